@@ -1,5 +1,10 @@
 #pragma once
+#include <typeinfo>
+#include <type_traits>
+#include <utility>
 
+/// Holds a value of any type. Move-only types can be stored and moved out
+/// again; copying an Any that holds one throws std::bad_cast.
 class Any {
     struct holder {
         virtual holder* clone() const = 0;
@@ -11,7 +16,11 @@ class Any {
         T val;
         typed(T&& val) : val(std::move(val)) {}
         typed(const T& val) : val(val) {}
-        holder* clone() const final override { T valCopy(val); return new typed(std::move(valCopy)); }
+        holder* clone() const final override { return clone(std::is_copy_constructible<T>{}); }
+        
+    private:
+        holder* clone(std::true_type) const { T valCopy(val); return new typed(std::move(valCopy)); }
+        holder* clone(std::false_type) const { throw std::bad_cast(); }
     };
     
     holder* val;
@@ -35,7 +44,8 @@ public:
     
     Any& operator = (Any&& o) {
         if(&o != this) {
-            val = std::move(o.val);
+            delete val;
+            val = o.val;
             o.val = nullptr;
         }
         return *this;
@@ -1,5 +1,6 @@
 #pragma once
 #include <Framework/Any.h>
+#include <utility>
 
 /// declaration of the template that has to be specialized for each visitable/visitor pair
 template <typename VISITABLE, typename VISITOR> struct
@@ -25,7 +26,7 @@ IVisitable : IVisitable<VISITORS...> {
 
     template <typename VISITOR_T>
     std::enable_if_t<has_visit_return_type<VISITOR_T>::value,typename VISITOR_T::visit_return_type> accept(VISITOR_T& visitor) {
-        return accept_untyped(visitor).template as<typename VISITOR_T::visit_return_type>();
+        return std::move(accept_untyped(visitor).template as<typename VISITOR_T::visit_return_type>());
     }
     
     template <typename VISITOR_T>
@@ -48,7 +49,7 @@ IVisitable<VISITOR> {
 
     template <typename VISITOR_T>
     std::enable_if_t<has_visit_return_type<VISITOR_T>::value,typename VISITOR_T::visit_return_type> accept(VISITOR_T& visitor) {
-        return accept_untyped(visitor).template as<typename VISITOR_T::visit_return_type>();
+        return std::move(accept_untyped(visitor).template as<typename VISITOR_T::visit_return_type>());
     }
     
     template <typename VISITOR_T>
@@ -11,6 +11,7 @@ template <> struct
 visit<CmosOV8825,Camera::Initialize> {
     static bool call(CmosOV8825& cctrl, Camera::Initialize& visitor) {
         std::cout << "CmosOV8825: Initialize()"<<std::endl;
+        cctrl.registers().program(OV8825::init);
         return true;
     }
 };
@@ -19,7 +20,14 @@ template <> struct
 visit<CmosOV3642,Camera::Initialize> {
     static bool call(CmosOV3642& cctrl, Camera::Initialize& visitor) {
         std::cout << "CmosOV3642: Initialize()"<<std::endl;
+        cctrl.registers().program(OV3642::init);
         return false;
     }
 };
 
+template <> struct
+visit<SyntheticCamera,Camera::Initialize> {
+    static bool call(SyntheticCamera& cctrl, Camera::Initialize& visitor) {
+        return true;
+    }
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include <HAL/CameraCtrl/Interfaces/ICameraCtrlVisitors.h>
+
+namespace Camera {
+
+    /// sensor timing for full resolution stills or for video; the output format stays the same
+    enum class Mode { Still, Video };
+
+    struct SetMode : CameraCtrlVisitorBase<SetMode,bool> {
+        Mode mode;
+        SetMode(Mode mode) : mode(mode) {}
+    };
+
+}
+
+template <> struct
+visit<CmosOV8825,Camera::SetMode> {
+    static bool call(CmosOV8825& cctrl, Camera::SetMode& visitor) {
+        cctrl.registers().program(visitor.mode == Camera::Mode::Still ? register_table(OV8825::stillMode) : register_table(OV8825::videoMode));
+        return true;
+    }
+};
+
+template <> struct
+visit<CmosOV3642,Camera::SetMode> {
+    static bool call(CmosOV3642& cctrl, Camera::SetMode& visitor) {
+        cctrl.registers().program(visitor.mode == Camera::Mode::Still ? register_table(OV3642::stillMode) : register_table(OV3642::videoMode));
+        return true;
+    }
+};
+
+template <> struct
+visit<SyntheticCamera,Camera::SetMode> {
+    static bool call(SyntheticCamera& cctrl, Camera::SetMode& visitor) {
+        return true;
+    }
+};
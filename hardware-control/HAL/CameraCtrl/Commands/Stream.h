@@ -0,0 +1,78 @@
+#pragma once
+#include <HAL/CameraCtrl/Interfaces/ICameraCtrlVisitors.h>
+#include <HAL/CameraCtrl/Interfaces/FrameStream.h>
+#include <chrono>
+#include <memory>
+
+namespace Camera {
+
+    /// Starts continuous capture, replacing a running stream. Single-shot
+    /// commands must not be sent to the camera while it streams.
+    struct StartStream : CameraCtrlVisitorBase<StartStream,std::shared_ptr<frame_stream>> {
+        double fps;
+        size_t buffers;
+        StartStream(double fps = 60.0, size_t buffers = 6u) : fps(fps), buffers(buffers) {}
+        
+        std::chrono::microseconds period() const {
+            return std::chrono::microseconds(static_cast<long long>(1e6 / fps));
+        }
+    };
+    
+    /// Stops continuous capture; returns whether a stream was running.
+    struct StopStream : CameraCtrlVisitorBase<StopStream,bool> {};
+    
+    template <typename CAMERA>
+    std::shared_ptr<frame_stream> startStream(CAMERA& cctrl, StartStream& cmd) {
+        return cctrl.stream.start(std::make_shared<frame_stream>(cctrl.format(), cmd.buffers, cmd.period(), [&cctrl](picture& pic){
+            cctrl.readFrame(pic);
+        }));
+    }
+
+}
+
+template <> struct
+visit<CmosOV8825,Camera::StartStream> {
+    static std::shared_ptr<frame_stream> call(CmosOV8825& cctrl, Camera::StartStream& visitor) {
+        std::cout << "CmosOV8825: StartStream()"<<std::endl;
+        return Camera::startStream(cctrl, visitor);
+    }
+};
+
+template <> struct
+visit<CmosOV3642,Camera::StartStream> {
+    static std::shared_ptr<frame_stream> call(CmosOV3642& cctrl, Camera::StartStream& visitor) {
+        std::cout << "CmosOV3642: StartStream()"<<std::endl;
+        return Camera::startStream(cctrl, visitor);
+    }
+};
+
+template <> struct
+visit<SyntheticCamera,Camera::StartStream> {
+    static std::shared_ptr<frame_stream> call(SyntheticCamera& cctrl, Camera::StartStream& visitor) {
+        return Camera::startStream(cctrl, visitor);
+    }
+};
+
+
+template <> struct
+visit<CmosOV8825,Camera::StopStream> {
+    static bool call(CmosOV8825& cctrl, Camera::StopStream& visitor) {
+        std::cout << "CmosOV8825: StopStream()"<<std::endl;
+        return cctrl.stream.reset();
+    }
+};
+
+template <> struct
+visit<CmosOV3642,Camera::StopStream> {
+    static bool call(CmosOV3642& cctrl, Camera::StopStream& visitor) {
+        std::cout << "CmosOV3642: StopStream()"<<std::endl;
+        return cctrl.stream.reset();
+    }
+};
+
+template <> struct
+visit<SyntheticCamera,Camera::StopStream> {
+    static bool call(SyntheticCamera& cctrl, Camera::StopStream& visitor) {
+        return cctrl.stream.reset();
+    }
+};
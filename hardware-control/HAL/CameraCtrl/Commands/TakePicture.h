@@ -1,19 +1,55 @@
 #pragma once
 #include <HAL/CameraCtrl/Interfaces/ICameraCtrlVisitors.h>
-
-struct picture {};
+#include <HAL/CameraCtrl/Interfaces/Picture.h>
+#include <functional>
+#include <stdexcept>
+#include <string>
 
 namespace Camera {
 
+    struct error : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    /// Takes a picture from the camera's pool. A caller that holds every
+    /// picture of the pool gets Camera::error instead of waiting for a buffer
+    /// only it could release.
     struct TakePicture : CameraCtrlVisitorBase<TakePicture,picture> {};
 
+    /// Takes count pictures in one submission and hands each to sink as soon
+    /// as it is read. The pictures come from the camera's pool; a sink that
+    /// keeps more of them than the pool holds makes the batch throw
+    /// Camera::error instead of waiting for a buffer nobody will release.
+    /// Returns the number of pictures taken.
+    struct TakePictures : CameraCtrlVisitorBase<TakePictures,size_t> {
+        size_t count;
+        std::function<void(picture)> sink;
+        TakePictures(size_t count, std::function<void(picture)> sink) : count(count), sink(std::move(sink)) {}
+    };
+
+    template <typename CAMERA>
+    picture takePicture(CAMERA& cctrl, const char* command) {
+        auto pic = cctrl.frames().try_acquire();
+        if(!pic)
+            throw error(std::string(command) + ": all " + std::to_string(cctrl.frames().capacity()) + " frame buffers are in use");
+        cctrl.readFrame(pic);
+        return pic;
+    }
+
+    template <typename CAMERA>
+    size_t takePictures(CAMERA& cctrl, TakePictures& cmd) {
+        for(size_t i = 0u; i < cmd.count; ++i)
+            cmd.sink(takePicture(cctrl, "TakePictures"));
+        return cmd.count;
+    }
+
 }
 
 template <> struct
 visit<CmosOV8825,Camera::TakePicture> {
     static picture call(CmosOV8825& cctrl, Camera::TakePicture& visitor) {
         std::cout << "CmosOV8825: TakePicture()"<<std::endl;
-        return picture{};
+        return Camera::takePicture(cctrl, "TakePicture");
     }
 };
 
@@ -22,7 +58,37 @@ template <> struct
 visit<CmosOV3642,Camera::TakePicture> {
     static picture call(CmosOV3642& cctrl, Camera::TakePicture& visitor) {
         std::cout << "CmosOV3642: TakePicture()"<<std::endl;
-        return picture{};
+        return Camera::takePicture(cctrl, "TakePicture");
+    }
+};
+
+template <> struct
+visit<SyntheticCamera,Camera::TakePicture> {
+    static picture call(SyntheticCamera& cctrl, Camera::TakePicture& visitor) {
+        return Camera::takePicture(cctrl, "TakePicture");
     }
 };
 
+
+template <> struct
+visit<CmosOV8825,Camera::TakePictures> {
+    static size_t call(CmosOV8825& cctrl, Camera::TakePictures& visitor) {
+        std::cout << "CmosOV8825: TakePictures("<<visitor.count<<")"<<std::endl;
+        return Camera::takePictures(cctrl, visitor);
+    }
+};
+
+template <> struct
+visit<CmosOV3642,Camera::TakePictures> {
+    static size_t call(CmosOV3642& cctrl, Camera::TakePictures& visitor) {
+        std::cout << "CmosOV3642: TakePictures("<<visitor.count<<")"<<std::endl;
+        return Camera::takePictures(cctrl, visitor);
+    }
+};
+
+template <> struct
+visit<SyntheticCamera,Camera::TakePictures> {
+    static size_t call(SyntheticCamera& cctrl, Camera::TakePictures& visitor) {
+        return Camera::takePictures(cctrl, visitor);
+    }
+};
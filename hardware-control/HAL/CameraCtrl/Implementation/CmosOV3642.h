@@ -1,8 +1,39 @@
 #pragma once
 #include <HAL/CameraCtrl/Interfaces/ICameraCtrl.h>
+#include <HAL/CameraCtrl/Interfaces/Picture.h>
+#include <HAL/CameraCtrl/Interfaces/FrameStream.h>
+#include <HAL/CameraCtrl/Interfaces/Sccb.h>
+#include <HAL/CameraCtrl/Implementation/CmosOV3642Registers.h>
+#include <memory>
 
 struct CmosOV3642 : CameraCtrlBase<CmosOV3642> {
+    /// 3 MP sensor
+    static frame_format format() { return { 2048u, 1536u }; }
+    
+    /// runs against a simulated register file unless given the sensor's bus
+    explicit CmosOV3642(std::shared_ptr<ISccbBus> bus = std::make_shared<SimulatedSccbBus>())
+        : bus(std::move(bus)), programmer(*this->bus)
+    {}
+    
+    /// the capture thread reads from the camera, so it is stopped before any member goes away
+    ~CmosOV3642() {
+        stream.reset();
+    }
+    
     void writeRegister(size_t addr, int value) {
-        std::cout << "CmosOV3642: writing value " << value << " to register addr " << addr << std::endl;
+        programmer.write(static_cast<uint16_t>(addr), static_cast<uint8_t>(value));
+    }
+    
+    RegisterProgrammer& registers() { return programmer; }
+    
+    static uint8_t testPattern(size_t x, size_t y, uint64_t frame) {
+        return static_cast<uint8_t>(x ^ y ^ frame);
     }
+    
+private:
+    std::shared_ptr<ISccbBus> bus;
+    RegisterProgrammer programmer;
+    
+public:
+    stream_slot stream;
 };
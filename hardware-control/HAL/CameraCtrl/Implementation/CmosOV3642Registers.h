@@ -0,0 +1,46 @@
+#pragma once
+#include <HAL/CameraCtrl/Interfaces/Sccb.h>
+
+/// Register tables of the OV3642: 2048x1536 RAW8 output, 24 MHz input clock.
+namespace OV3642 {
+
+    constexpr reg_write init[] = {
+        { 0x3012, 0x80, true },     // software reset
+        { 0x304d, 0x45 }, { 0x30a7, 0x5e }, { 0x3087, 0x16 }, { 0x309c, 0x1a },
+        { 0x30a2, 0xe4 }, { 0x30aa, 0x42 }, { 0x30b0, 0xff }, { 0x30b1, 0xff },
+        { 0x30b2, 0x10 },
+        { 0x300e, 0x32 }, { 0x300f, 0x21 }, { 0x3010, 0x20 }, { 0x3011, 0x01 },
+        { 0x304c, 0x82 },
+        { 0x3013, 0xf7 }, { 0x3014, 0x84 }, { 0x3015, 0x02 }, { 0x3016, 0xc1 },
+        { 0x3018, 0x38 }, { 0x3019, 0x30 }, { 0x301a, 0x82 },
+        { 0x3020, 0x01 }, { 0x3021, 0x1d },     // x start
+        { 0x3022, 0x00 }, { 0x3023, 0x0a },     // y start
+        { 0x3024, 0x08 }, { 0x3025, 0x18 },     // width
+        { 0x3026, 0x06 }, { 0x3027, 0x0c },     // height
+        { 0x3088, 0x08 }, { 0x3089, 0x00 },     // output width 2048
+        { 0x308a, 0x06 }, { 0x308b, 0x00 },     // output height 1536
+        { 0x3300, 0xfc }, { 0x3302, 0x01 }, { 0x3400, 0x00 }, { 0x3606, 0x20 },
+        { 0x3601, 0x30 }, { 0x30f3, 0x83 }, { 0x304e, 0x88 },
+        { 0x3600, 0xc4 }, { 0x3603, 0x27 }, { 0x3604, 0x07 }, { 0x3605, 0x04 },
+        { 0x3086, 0x00 },
+    };
+    
+    /// frame timing for full resolution stills, 7.5 fps
+    constexpr reg_write stillMode[] = {
+        { 0x3086, 0x01 },                       // standby
+        { 0x300e, 0x32 }, { 0x300f, 0x21 }, { 0x3010, 0x20 }, { 0x3011, 0x01 },
+        { 0x3028, 0x0a }, { 0x3029, 0x00 },     // line length 2560
+        { 0x302a, 0x06 }, { 0x302b, 0x20 },     // frame length 1568
+        { 0x3086, 0x00 },
+    };
+    
+    /// frame timing for video, 15 fps
+    constexpr reg_write videoMode[] = {
+        { 0x3086, 0x01 },                       // standby
+        { 0x300e, 0x34 }, { 0x300f, 0x21 }, { 0x3010, 0x20 }, { 0x3011, 0x00 },
+        { 0x3028, 0x0a }, { 0x3029, 0x00 },     // line length 2560
+        { 0x302a, 0x06 }, { 0x302b, 0x20 },     // frame length 1568
+        { 0x3086, 0x00 },
+    };
+
+}
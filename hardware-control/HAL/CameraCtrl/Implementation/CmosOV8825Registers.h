@@ -0,0 +1,66 @@
+#pragma once
+#include <HAL/CameraCtrl/Interfaces/Sccb.h>
+
+/// Register tables of the OV8825: 3264x2448 RAW8 output, 24 MHz input clock.
+namespace OV8825 {
+
+    constexpr reg_write init[] = {
+        { 0x0103, 0x01, true },     // software reset
+        { 0x0100, 0x00 },           // standby
+        { 0x3000, 0x16 }, { 0x3001, 0x00 }, { 0x3002, 0x6c },
+        { 0x3003, 0xce }, { 0x3004, 0xd4 }, { 0x3005, 0x00 }, { 0x3006, 0x10 },
+        { 0x3007, 0x3b },
+        { 0x300d, 0x00 },
+        { 0x301f, 0x09 }, { 0x3020, 0x01 },
+        { 0x3106, 0x00 },
+        { 0x3400, 0x04 }, { 0x3401, 0x00 }, { 0x3402, 0x04 }, { 0x3403, 0x00 },
+        { 0x3404, 0x04 }, { 0x3405, 0x00 }, { 0x3406, 0x01 },
+        { 0x3500, 0x00 }, { 0x3501, 0x9a }, { 0x3502, 0x20 }, { 0x3503, 0x07 },
+        { 0x3509, 0x00 }, { 0x350a, 0x00 }, { 0x350b, 0x1f },
+        { 0x3600, 0x06 }, { 0x3601, 0x34 }, { 0x3602, 0x42 }, { 0x3603, 0x5c },
+        { 0x3604, 0x98 }, { 0x3605, 0xf5 }, { 0x3609, 0xb4 }, { 0x360a, 0x7c },
+        { 0x360b, 0xc9 }, { 0x360c, 0x0b },
+        { 0x3700, 0x48 }, { 0x3701, 0x18 }, { 0x3702, 0x50 }, { 0x3703, 0x32 },
+        { 0x3704, 0x28 }, { 0x3705, 0x00 }, { 0x3706, 0x70 }, { 0x3707, 0x08 },
+        { 0x3708, 0x48 }, { 0x3709, 0x80 }, { 0x370a, 0x01 }, { 0x370b, 0x70 },
+        { 0x3800, 0x00 }, { 0x3801, 0x04 },     // x start
+        { 0x3802, 0x00 }, { 0x3803, 0x00 },     // y start
+        { 0x3804, 0x0c }, { 0x3805, 0xcb },     // x end
+        { 0x3806, 0x09 }, { 0x3807, 0x9b },     // y end
+        { 0x3808, 0x0c }, { 0x3809, 0xc0 },     // output width 3264
+        { 0x380a, 0x09 }, { 0x380b, 0x90 },     // output height 2448
+        { 0x3810, 0x00 }, { 0x3811, 0x04 }, { 0x3812, 0x00 }, { 0x3813, 0x04 },
+        { 0x3814, 0x11 }, { 0x3815, 0x11 },
+        { 0x3820, 0x80 }, { 0x3821, 0x16 },
+        { 0x4000, 0x10 }, { 0x4002, 0xc5 }, { 0x4005, 0x18 }, { 0x4006, 0x20 },
+        { 0x4008, 0x20 }, { 0x4009, 0x10 },
+        { 0x4300, 0xff }, { 0x4303, 0x00 }, { 0x4304, 0x08 }, { 0x4307, 0x00 },
+        { 0x4800, 0x04 }, { 0x4801, 0x0f }, { 0x4843, 0x02 },
+        { 0x5000, 0x06 }, { 0x5001, 0x00 }, { 0x5002, 0x00 }, { 0x5068, 0x00 },
+    };
+    
+    /// PLL and frame timing for full resolution stills, 15 fps
+    constexpr reg_write stillMode[] = {
+        { 0x0100, 0x00 },
+        { 0x3090, 0x03 }, { 0x3091, 0x22 }, { 0x3092, 0x01 }, { 0x3093, 0x00 },
+        { 0x3094, 0x00 }, { 0x3098, 0x03 }, { 0x3099, 0x1e }, { 0x309a, 0x01 },
+        { 0x309b, 0x00 }, { 0x309c, 0x00 },
+        { 0x380c, 0x0e }, { 0x380d, 0x00 },     // line length 3584
+        { 0x380e, 0x09 }, { 0x380f, 0xb0 },     // frame length 2480
+        { 0x3a04, 0x09 }, { 0x3a05, 0xa8 },
+        { 0x0100, 0x01 },
+    };
+    
+    /// PLL and frame timing for video, 30 fps
+    constexpr reg_write videoMode[] = {
+        { 0x0100, 0x00 },
+        { 0x3090, 0x02 }, { 0x3091, 0x22 }, { 0x3092, 0x00 }, { 0x3093, 0x00 },
+        { 0x3094, 0x00 }, { 0x3098, 0x03 }, { 0x3099, 0x1e }, { 0x309a, 0x00 },
+        { 0x309b, 0x00 }, { 0x309c, 0x00 },
+        { 0x380c, 0x0e }, { 0x380d, 0x00 },     // line length 3584
+        { 0x380e, 0x09 }, { 0x380f, 0xb0 },     // frame length 2480
+        { 0x3a04, 0x09 }, { 0x3a05, 0xa8 },
+        { 0x0100, 0x01 },
+    };
+
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <HAL/CameraCtrl/Interfaces/ICameraCtrl.h>
+#include <HAL/CameraCtrl/Interfaces/Picture.h>
+#include <HAL/CameraCtrl/Interfaces/FrameStream.h>
+
+/// Stand-in sensor generating synthetic frames, for running the camera
+/// commands without hardware. Every pixel of a frame is the low byte of
+/// x + y + the frame's sequence number.
+struct SyntheticCamera : CameraCtrlBase<SyntheticCamera> {
+    explicit SyntheticCamera(frame_format fmt = { 640u, 480u })
+        : fmt(fmt)
+    {}
+    
+    /// the capture thread reads from the camera, so it is stopped before any member goes away
+    ~SyntheticCamera() {
+        stream.reset();
+    }
+    
+    frame_format format() const { return fmt; }
+    
+    void writeRegister(size_t addr, int value) {}
+    
+    static uint8_t testPattern(size_t x, size_t y, uint64_t frame) {
+        return static_cast<uint8_t>(x + y + frame);
+    }
+    
+private:
+    const frame_format fmt;
+    
+public:
+    stream_slot stream;
+};
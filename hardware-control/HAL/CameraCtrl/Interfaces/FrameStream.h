@@ -0,0 +1,157 @@
+#pragma once
+#include <HAL/CameraCtrl/Interfaces/Picture.h>
+#include <TDD/concurrent_observable.h>
+#include <TDD/triple_buffer.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/// Continuous capture: a thread reads frames at a fixed rate into buffers of
+/// its own frame_pool. Consumers either poll the latest completed frame
+/// without locking (one polling consumer per stream), or subscribe to
+/// frames(), whose listeners are called on the capture thread and should
+/// return quickly. A frame stays valid while anybody holds it; if no buffer is
+/// free when a frame is due, that frame is dropped instead of delaying the
+/// following ones. A listener may stop the stream, and so destroy it; the
+/// capture thread then shares the state it works on, and exits after the
+/// current frame.
+class frame_stream {
+    using frame = std::shared_ptr<const picture>;
+    
+    struct state {
+        const std::shared_ptr<frame_pool> pool;
+        const std::chrono::microseconds period;
+        const std::function<void(picture&)> readout;
+        triple_buffer<frame> exchange;
+        concurrent_observable<frame> subscribers;
+        std::atomic<uint64_t> capturedFrames{0u};
+        std::atomic<uint64_t> droppedFrames{0u};
+        std::mutex mutex;
+        std::condition_variable stopRequested;
+        bool stopping = false;
+        
+        state(frame_format fmt, size_t buffers, std::chrono::microseconds period, std::function<void(picture&)> readout);
+        
+        void run();
+    };
+    
+    const std::shared_ptr<state> shared;   ///< also held by the capture thread while it runs
+    std::thread capture;
+    
+public:
+    frame_stream(frame_format fmt, size_t buffers, std::chrono::microseconds period, std::function<void(picture&)> readout);
+    
+    frame_stream(const frame_stream&) = delete;
+    
+    ~frame_stream();
+    
+    /// stops capturing; frames already handed out stay valid. Called from the
+    /// capture thread, it does not wait for the thread to exit.
+    void stop();
+    
+    /// the most recent frame, or null before the first one; never blocks
+    frame latest();
+    
+    iobservable<frame>& frames() { return shared->subscribers; }
+    
+    uint64_t captured() const { return shared->capturedFrames; }
+    
+    uint64_t dropped() const { return shared->droppedFrames; }
+};
+
+
+/// The stream of a camera. The capture thread reads from the camera, so a
+/// camera stops its stream with reset() in its destructor, before its
+/// members are destroyed.
+class stream_slot {
+    std::shared_ptr<frame_stream> current;
+    
+public:
+    stream_slot() = default;
+    
+    stream_slot(const stream_slot&) = delete;
+    
+    ~stream_slot() { reset(); }
+    
+    const std::shared_ptr<frame_stream>& start(std::shared_ptr<frame_stream> stream) {
+        reset();
+        return current = std::move(stream);
+    }
+    
+    /// true if a stream was running
+    bool reset() {
+        if(!current)
+            return false;
+        current->stop();
+        current = nullptr;
+        return true;
+    }
+};
+
+
+inline frame_stream::state::state(frame_format fmt, size_t buffers, std::chrono::microseconds period, std::function<void(picture&)> readout)
+    : pool(frame_pool::create(fmt, buffers)),
+      period(period),
+      readout(std::move(readout)),
+      subscribers(nullptr)
+{
+}
+
+inline frame_stream::frame_stream(frame_format fmt, size_t buffers, std::chrono::microseconds period, std::function<void(picture&)> readout)
+    : shared(std::make_shared<state>(fmt, buffers, period, std::move(readout))),
+      capture([s = shared]{ s->run(); })
+{
+}
+
+inline frame_stream::~frame_stream() {
+    stop();
+}
+
+inline void frame_stream::stop() {
+    {
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        shared->stopping = true;
+    }
+    shared->stopRequested.notify_one();
+    if(!capture.joinable())
+        return;
+    if(capture.get_id() == std::this_thread::get_id())
+        capture.detach();
+    else
+        capture.join();
+}
+
+inline std::shared_ptr<const picture> frame_stream::latest() {
+    shared->exchange.update();
+    return shared->exchange.front_buffer();
+}
+
+inline void frame_stream::state::run() {
+    auto due = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(mutex);
+    while(!stopping) {
+        lock.unlock();
+        // the frame in the back buffer was superseded; its buffer can be reused
+        exchange.back_buffer() = nullptr;
+        if(auto pic = pool->try_acquire()) {
+            readout(pic);
+            ++capturedFrames;
+            frame completed = std::make_shared<picture>(std::move(pic));
+            exchange.back_buffer() = completed;
+            exchange.publish();
+            subscribers = std::move(completed);
+        }
+        else
+            ++droppedFrames;
+        due += period;
+        const auto now = std::chrono::steady_clock::now();
+        if(due < now)
+            due = now;
+        lock.lock();
+        stopRequested.wait_until(lock, due, [this]{ return stopping; });
+    }
+}
@@ -1,11 +1,38 @@
 #pragma once
 #include "Visitable.h"
 #include "ICameraCtrlVisitors.h"
+#include <HAL/CameraCtrl/Interfaces/Picture.h>
+#include <cstdint>
+#include <memory>
 
 using ICameraCtrl = IVisitable<
                         ICameraCtrlVisitorBase
                     >;
 
 
-template <typename CLASS> using
-CameraCtrlBase = Visitable<CLASS,ICameraCtrl>;
\ No newline at end of file
+/// Frame buffers and readout shared by the cameras. CLASS provides format()
+/// and testPattern(x, y, frame).
+template <typename CLASS> struct
+CameraCtrlBase : Visitable<CLASS,ICameraCtrl> {
+    /// pool of the single-shot commands; the buffers are allocated on first use
+    frame_pool& frames() {
+        if(!pool)
+            pool = frame_pool::create(static_cast<CLASS&>(*this).format(), 3u);
+        return *pool;
+    }
+    
+    /// Stub: the HAL has no pixel interface to the sensors yet, so the frame
+    /// is filled with the sensor's test pattern instead of being read out.
+    void readFrame(picture& pic) {
+        const auto& fmt = pic.format();
+        uint8_t* row = pic.data();
+        for(size_t y = 0u; y < fmt.height; ++y, row += fmt.width)
+            for(size_t x = 0u; x < fmt.width; ++x)
+                row[x] = CLASS::testPattern(x, y, frameCount);
+        pic.set_sequence(frameCount++);
+    }
+    
+private:
+    std::shared_ptr<frame_pool> pool;
+    uint64_t frameCount = 0u;
+};
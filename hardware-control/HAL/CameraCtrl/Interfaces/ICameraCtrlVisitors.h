@@ -5,10 +5,11 @@
 
 struct CmosOV3642;;
 struct CmosOV8825;
+struct SyntheticCamera;
 
 
-struct ICameraCtrlVisitorBase : IVisitor<CmosOV3642,CmosOV8825> {};
+struct ICameraCtrlVisitorBase : IVisitor<CmosOV3642,CmosOV8825,SyntheticCamera> {};
 
 
 template <typename CLASS, typename RETURN_TYPE> using
-CameraCtrlVisitorBase = Visitor<CLASS,RETURN_TYPE,ICameraCtrlVisitorBase,CmosOV3642,CmosOV8825>;
+CameraCtrlVisitorBase = Visitor<CLASS,RETURN_TYPE,ICameraCtrlVisitorBase,CmosOV3642,CmosOV8825,SyntheticCamera>;
@@ -0,0 +1,169 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+#include <unistd.h>
+
+/// Geometry of a raw sensor frame; one byte per pixel, Bayer pattern.
+struct frame_format {
+    size_t width = 0u;
+    size_t height = 0u;
+    
+    size_t bytes() const { return width * height; }
+};
+
+
+class frame_pool;
+
+/// Handle to a frame buffer of a frame_pool. Pictures are move-only: moving one
+/// hands the pixels on without copying, and destroying one returns the buffer
+/// to its pool. A default constructed picture holds no buffer.
+class picture {
+    friend class frame_pool;
+    
+    struct release {
+        std::shared_ptr<frame_pool> pool;
+        void operator()(uint8_t* buffer) const;
+    };
+    
+    std::unique_ptr<uint8_t,release> buffer;
+    frame_format fmt;
+    uint64_t seq = 0u;
+    
+    picture(uint8_t* buffer, std::shared_ptr<frame_pool> pool, frame_format fmt);
+    
+public:
+    picture() = default;
+    
+    picture(picture&&) = default;
+    
+    picture& operator = (picture&&) = default;
+    
+    explicit operator bool() const { return buffer != nullptr; }
+    
+    uint8_t* data() { return buffer.get(); }
+    
+    const uint8_t* data() const { return buffer.get(); }
+    
+    size_t size() const { return buffer ? fmt.bytes() : 0u; }
+    
+    const frame_format& format() const { return fmt; }
+    
+    /// number of the frame within the stream it was captured from
+    uint64_t sequence() const { return seq; }
+    
+    void set_sequence(uint64_t s) { seq = s; }
+};
+
+
+/// Preallocated, page-aligned frame buffers handed out as pictures. The pool
+/// stays alive as long as any of its pictures does.
+class frame_pool : public std::enable_shared_from_this<frame_pool> {
+    friend class picture;
+    
+    struct free_buffer {
+        void operator()(uint8_t* buffer) const { std::free(buffer); }
+    };
+    
+    const frame_format fmt;
+    std::vector<std::unique_ptr<uint8_t,free_buffer>> buffers;
+    std::mutex mutex;
+    std::condition_variable released;
+    std::vector<uint8_t*> available;
+    
+    void give_back(uint8_t* buffer);
+    
+    struct private_tag {};
+    
+public:
+    frame_pool(private_tag, frame_format fmt, size_t count);
+    
+    frame_pool(const frame_pool&) = delete;
+    
+    static std::shared_ptr<frame_pool> create(frame_format fmt, size_t count);
+    
+    /// waits until a buffer is available
+    picture acquire();
+    
+    /// an empty picture if all buffers are in use
+    picture try_acquire();
+    
+    const frame_format& format() const { return fmt; }
+    
+    size_t capacity() const { return buffers.size(); }
+    
+    size_t free_count();
+    
+    static size_t page_size();
+};
+
+
+inline void picture::release::operator()(uint8_t* buffer) const {
+    pool->give_back(buffer);
+}
+
+inline picture::picture(uint8_t* buffer, std::shared_ptr<frame_pool> pool, frame_format fmt)
+    : buffer(buffer, release{std::move(pool)}), fmt(fmt)
+{
+}
+
+
+inline size_t frame_pool::page_size() {
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+inline frame_pool::frame_pool(private_tag, frame_format fmt, size_t count)
+    : fmt(fmt)
+{
+    const size_t page = page_size();
+    const size_t bytes = (fmt.bytes() + page - 1u) / page * page;
+    buffers.reserve(count);
+    available.reserve(count);
+    for(size_t i = 0u; i < count; ++i) {
+        void* mem = nullptr;
+        if(posix_memalign(&mem, page, bytes ? bytes : page))
+            throw std::bad_alloc();
+        buffers.emplace_back(static_cast<uint8_t*>(mem));
+        available.push_back(static_cast<uint8_t*>(mem));
+    }
+}
+
+inline std::shared_ptr<frame_pool> frame_pool::create(frame_format fmt, size_t count) {
+    return std::make_shared<frame_pool>(private_tag{}, fmt, count);
+}
+
+inline picture frame_pool::acquire() {
+    std::unique_lock<std::mutex> lock(mutex);
+    released.wait(lock, [this]{ return !available.empty(); });
+    auto buffer = available.back();
+    available.pop_back();
+    return picture(buffer, shared_from_this(), fmt);
+}
+
+inline picture frame_pool::try_acquire() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if(available.empty())
+        return picture();
+    auto buffer = available.back();
+    available.pop_back();
+    return picture(buffer, shared_from_this(), fmt);
+}
+
+inline size_t frame_pool::free_count() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return available.size();
+}
+
+inline void frame_pool::give_back(uint8_t* buffer) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        available.push_back(buffer);
+    }
+    released.notify_one();
+}
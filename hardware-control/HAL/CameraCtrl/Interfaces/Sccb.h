@@ -0,0 +1,130 @@
+#pragma once
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// One entry of a register table. Writing a resetting register changes other
+/// registers of the sensor, so it is always written and forgets the shadow.
+struct reg_write {
+    uint16_t addr;
+    uint8_t value;
+    bool resets;
+    
+    constexpr reg_write(uint16_t addr, uint8_t value, bool resets = false)
+        : addr(addr), value(value), resets(resets)
+    {}
+};
+
+/// View of a constexpr register table.
+class register_table {
+    const reg_write* entries;
+    size_t count;
+    
+public:
+    template <size_t N>
+    constexpr register_table(const reg_write (&table)[N])
+        : entries(table), count(N)
+    {}
+    
+    constexpr const reg_write* begin() const { return entries; }
+    constexpr const reg_write* end() const { return entries + count; }
+    constexpr size_t size() const { return count; }
+};
+
+
+/// SCCB (I2C compatible) bus to the sensor's 16 bit register space. A burst
+/// writes consecutive registers in one transaction, relying on the sensor's
+/// address auto-increment.
+struct ISccbBus {
+    virtual ~ISccbBus() {}
+    virtual void writeBurst(uint16_t addr, const uint8_t* values, size_t count) = 0;
+    virtual uint8_t read(uint16_t addr) = 0;
+};
+
+
+/// Register file standing in for a sensor, with the transfer time the
+/// transactions would take on a 400 kHz bus.
+class SimulatedSccbBus final : public ISccbBus {
+    std::array<uint8_t,0x10000> registers{};
+    size_t transactionCount = 0u;
+    size_t byteCount = 0u;
+    
+public:
+    void writeBurst(uint16_t addr, const uint8_t* values, size_t count) override {
+        for(size_t i = 0u; i < count; ++i)
+            registers[static_cast<uint16_t>(addr + i)] = values[i];
+        ++transactionCount;
+        byteCount += 3u + count;    // device address, register address, data
+    }
+    
+    uint8_t read(uint16_t addr) override {
+        ++transactionCount;
+        byteCount += 4u;
+        return registers[addr];
+    }
+    
+    uint8_t operator[] (uint16_t addr) const { return registers[addr]; }
+    
+    size_t transactions() const { return transactionCount; }
+    
+    /// 9 clocks per byte at 400 kHz
+    double busTimeMs() const { return byteCount * 9u / 400.0; }
+};
+
+
+/// Writes register tables to a sensor. Registers whose last written value is
+/// still current are skipped, and runs of consecutive addresses are sent as
+/// one burst. The shadow only knows what was written through this object;
+/// call invalidate() after anything else changed the sensor's registers.
+class RegisterProgrammer {
+    ISccbBus& bus;
+    std::array<uint8_t,0x10000> shadow{};
+    std::bitset<0x10000> known;
+    std::vector<uint8_t> burst;
+    uint16_t burstStart = 0u;
+    
+    void flush() {
+        if(!burst.empty())
+            bus.writeBurst(burstStart, burst.data(), burst.size());
+        burst.clear();
+    }
+    
+public:
+    static constexpr size_t maxBurst = 64u;
+    
+    explicit RegisterProgrammer(ISccbBus& bus) : bus(bus) {
+        burst.reserve(maxBurst);
+    }
+    
+    void program(register_table table) {
+        for(const auto& w : table) {
+            if(w.resets) {
+                flush();
+                bus.writeBurst(w.addr, &w.value, 1u);
+                invalidate();
+                continue;
+            }
+            if(known[w.addr] && shadow[w.addr] == w.value)
+                continue;
+            if(burst.size() == maxBurst || (!burst.empty() && w.addr != burstStart + burst.size()))
+                flush();
+            if(burst.empty())
+                burstStart = w.addr;
+            burst.push_back(w.value);
+            shadow[w.addr] = w.value;
+            known[w.addr] = true;
+        }
+        flush();
+    }
+    
+    void write(uint16_t addr, uint8_t value) {
+        const reg_write single[] = { { addr, value } };
+        program(single);
+    }
+    
+    void invalidate() {
+        known.reset();
+    }
+};
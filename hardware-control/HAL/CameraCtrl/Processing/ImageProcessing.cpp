@@ -0,0 +1,433 @@
+#include "ImageProcessing.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PROCESSING_X86 1
+#endif
+
+namespace Processing {
+
+namespace {
+
+    inline uint8_t average(unsigned a, unsigned b) {
+        return static_cast<uint8_t>((a + b + 1u) >> 1);
+    }
+    
+    /// 2x2 averages are formed as the SIMD instructions do: rows first, then columns
+    inline uint8_t average4(const uint8_t* row0, const uint8_t* row1, size_t x) {
+        return average(average(row0[2*x], row1[2*x]), average(row0[2*x+1], row1[2*x+1]));
+    }
+    
+    void grayScalar(const uint8_t* r, const uint8_t* g, const uint8_t* b, uint8_t* y, size_t n) {
+        for(size_t i = 0u; i < n; ++i)
+            y[i] = static_cast<uint8_t>((77u * r[i] + 150u * g[i] + 29u * b[i]) >> 8);
+    }
+    
+    void halveRowScalar(const uint8_t* row0, const uint8_t* row1, uint8_t* out, size_t width) {
+        for(size_t x = 0u; x < width; ++x)
+            out[x] = average4(row0, row1, x);
+    }
+    
+    /// a Bayer pixel and its eight neighbours
+    struct bayer_site {
+        unsigned self, left, right, up, down, upLeft, upRight, downLeft, downRight;
+    };
+    
+    /// Bilinear interpolation: each missing color is the mean of the nearest
+    /// pixels of that color.
+    inline void interpolate(const bayer_site& s, bool redRow, bool evenColumn, uint8_t& r, uint8_t& g, uint8_t& b) {
+        const unsigned cross = (s.left + s.right + s.up + s.down + 2u) / 4u;
+        const unsigned diagonal = (s.upLeft + s.upRight + s.downLeft + s.downRight + 2u) / 4u;
+        const unsigned horizontal = (s.left + s.right + 1u) / 2u;
+        const unsigned vertical = (s.up + s.down + 1u) / 2u;
+        unsigned cr, cg, cb;
+        if(redRow && evenColumn)        { cr = s.self; cg = cross; cb = diagonal; }       // R
+        else if(!redRow && !evenColumn) { cr = diagonal; cg = cross; cb = s.self; }       // B
+        else if(redRow)                 { cr = horizontal; cg = s.self; cb = vertical; }  // G in a red row
+        else                            { cr = vertical; cg = s.self; cb = horizontal; }  // G in a blue row
+        r = static_cast<uint8_t>(cr);
+        g = static_cast<uint8_t>(cg);
+        b = static_cast<uint8_t>(cb);
+    }
+    
+    /// columns [x, end) of an interior row; the neighbours of all of them lie within the frame
+    void demosaicRowScalar(const uint8_t* up, const uint8_t* mid, const uint8_t* down, size_t x, size_t end,
+                           bool redRow, uint8_t* r, uint8_t* g, uint8_t* b) {
+        for(; x < end; ++x) {
+            const bayer_site s = { mid[x], mid[x-1], mid[x+1], up[x], down[x], up[x-1], up[x+1], down[x-1], down[x+1] };
+            interpolate(s, redRow, x % 2u == 0u, r[x], g[x], b[x]);
+        }
+    }
+
+#ifdef PROCESSING_X86
+    
+    /// 16 bit lanes: (77 r + 150 g + 29 b) >> 8, which fits since the weights add up to 256
+    __attribute__((target("sse2")))
+    inline __m128i grayLanes(__m128i r, __m128i g, __m128i b) {
+        const __m128i sum = _mm_add_epi16(_mm_add_epi16(
+            _mm_mullo_epi16(r, _mm_set1_epi16(77)),
+            _mm_mullo_epi16(g, _mm_set1_epi16(150))),
+            _mm_mullo_epi16(b, _mm_set1_epi16(29)));
+        return _mm_srli_epi16(sum, 8);
+    }
+    
+    __attribute__((target("sse2")))
+    void graySSE2(const uint8_t* r, const uint8_t* g, const uint8_t* b, uint8_t* y, size_t n) {
+        const __m128i zero = _mm_setzero_si128();
+        size_t i = 0u;
+        for(; i + 16u <= n; i += 16u) {
+            const __m128i vr = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r + i));
+            const __m128i vg = _mm_loadu_si128(reinterpret_cast<const __m128i*>(g + i));
+            const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            const __m128i lo = grayLanes(_mm_unpacklo_epi8(vr, zero), _mm_unpacklo_epi8(vg, zero), _mm_unpacklo_epi8(vb, zero));
+            const __m128i hi = grayLanes(_mm_unpackhi_epi8(vr, zero), _mm_unpackhi_epi8(vg, zero), _mm_unpackhi_epi8(vb, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(y + i), _mm_packus_epi16(lo, hi));
+        }
+        grayScalar(r + i, g + i, b + i, y + i, n - i);
+    }
+    
+    __attribute__((target("sse2")))
+    void halveRowSSE2(const uint8_t* row0, const uint8_t* row1, uint8_t* out, size_t width) {
+        const __m128i low = _mm_set1_epi16(0x00ff);
+        const __m128i one = _mm_set1_epi16(1);
+        size_t x = 0u;
+        for(; x + 16u <= width; x += 16u) {
+            const __m128i a = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 2*x)),
+                                           _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 2*x)));
+            const __m128i b = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 2*x + 16)),
+                                           _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 2*x + 16)));
+            const __m128i sa = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_and_si128(a, low), _mm_srli_epi16(a, 8)), one), 1);
+            const __m128i sb = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_and_si128(b, low), _mm_srli_epi16(b, 8)), one), 1);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(sa, sb));
+        }
+        halveRowScalar(row0 + 2*x, row1 + 2*x, out + x, width - x);
+    }
+    
+    /// (a + b + c + d + 2) / 4 per byte, summed in 16 bit lanes
+    __attribute__((target("sse2")))
+    inline __m128i mean4SSE2(__m128i a, __m128i b, __m128i c, __m128i d) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i two = _mm_set1_epi16(2);
+        const __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)),
+                                         _mm_add_epi16(_mm_unpacklo_epi8(c, zero), _mm_unpacklo_epi8(d, zero)));
+        const __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)),
+                                         _mm_add_epi16(_mm_unpackhi_epi8(c, zero), _mm_unpackhi_epi8(d, zero)));
+        return _mm_packus_epi16(_mm_srli_epi16(_mm_add_epi16(lo, two), 2), _mm_srli_epi16(_mm_add_epi16(hi, two), 2));
+    }
+    
+    __attribute__((target("sse2")))
+    inline __m128i selectSSE2(__m128i mask, __m128i a, __m128i b) {
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    }
+    
+    /// all four interpolations for 16 pixels, then the Bayer phase picks per
+    /// column; (a + b + 1) / 2 is exactly _mm_avg_epu8
+    __attribute__((target("sse2")))
+    void demosaicRowSSE2(const uint8_t* up, const uint8_t* mid, const uint8_t* down, size_t x, size_t end,
+                         bool redRow, uint8_t* r, uint8_t* g, uint8_t* b) {
+        // x advances by 16, so the lanes of the even columns stay the same
+        const __m128i evenColumn = _mm_set1_epi16(static_cast<short>(x % 2u ? 0xff00 : 0x00ff));
+        for(; x + 16u <= end; x += 16u) {
+            const __m128i self = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mid + x));
+            const __m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mid + x - 1));
+            const __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mid + x + 1));
+            const __m128i above = _mm_loadu_si128(reinterpret_cast<const __m128i*>(up + x));
+            const __m128i below = _mm_loadu_si128(reinterpret_cast<const __m128i*>(down + x));
+            const __m128i cross = mean4SSE2(left, right, above, below);
+            const __m128i diagonal = mean4SSE2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(up + x - 1)),
+                                               _mm_loadu_si128(reinterpret_cast<const __m128i*>(up + x + 1)),
+                                               _mm_loadu_si128(reinterpret_cast<const __m128i*>(down + x - 1)),
+                                               _mm_loadu_si128(reinterpret_cast<const __m128i*>(down + x + 1)));
+            const __m128i horizontal = _mm_avg_epu8(left, right);
+            const __m128i vertical = _mm_avg_epu8(above, below);
+            __m128i vr, vg, vb;
+            if(redRow) {
+                vr = selectSSE2(evenColumn, self, horizontal);
+                vg = selectSSE2(evenColumn, cross, self);
+                vb = selectSSE2(evenColumn, diagonal, vertical);
+            } else {
+                vr = selectSSE2(evenColumn, vertical, diagonal);
+                vg = selectSSE2(evenColumn, self, cross);
+                vb = selectSSE2(evenColumn, horizontal, self);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(r + x), vr);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(g + x), vg);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(b + x), vb);
+        }
+        demosaicRowScalar(up, mid, down, x, end, redRow, r, g, b);
+    }
+    
+    __attribute__((target("avx2")))
+    inline __m256i grayLanesAVX2(__m256i r, __m256i g, __m256i b) {
+        const __m256i sum = _mm256_add_epi16(_mm256_add_epi16(
+            _mm256_mullo_epi16(r, _mm256_set1_epi16(77)),
+            _mm256_mullo_epi16(g, _mm256_set1_epi16(150))),
+            _mm256_mullo_epi16(b, _mm256_set1_epi16(29)));
+        return _mm256_srli_epi16(sum, 8);
+    }
+    
+    /// unpacking and packing work within 128 bit lanes, so the packed result
+    /// comes out in the original order again
+    __attribute__((target("avx2")))
+    void grayAVX2(const uint8_t* r, const uint8_t* g, const uint8_t* b, uint8_t* y, size_t n) {
+        const __m256i zero = _mm256_setzero_si256();
+        size_t i = 0u;
+        for(; i + 32u <= n; i += 32u) {
+            const __m256i vr = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r + i));
+            const __m256i vg = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(g + i));
+            const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            const __m256i lo = grayLanesAVX2(_mm256_unpacklo_epi8(vr, zero), _mm256_unpacklo_epi8(vg, zero), _mm256_unpacklo_epi8(vb, zero));
+            const __m256i hi = grayLanesAVX2(_mm256_unpackhi_epi8(vr, zero), _mm256_unpackhi_epi8(vg, zero), _mm256_unpackhi_epi8(vb, zero));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(y + i), _mm256_packus_epi16(lo, hi));
+        }
+        graySSE2(r + i, g + i, b + i, y + i, n - i);
+    }
+    
+    /// packing interleaves the 128 bit lanes of both inputs; the permutation restores the order
+    __attribute__((target("avx2")))
+    void halveRowAVX2(const uint8_t* row0, const uint8_t* row1, uint8_t* out, size_t width) {
+        const __m256i low = _mm256_set1_epi16(0x00ff);
+        const __m256i one = _mm256_set1_epi16(1);
+        size_t x = 0u;
+        for(; x + 32u <= width; x += 32u) {
+            const __m256i a = _mm256_avg_epu8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0 + 2*x)),
+                                              _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1 + 2*x)));
+            const __m256i b = _mm256_avg_epu8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0 + 2*x + 32)),
+                                              _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1 + 2*x + 32)));
+            const __m256i sa = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(_mm256_and_si256(a, low), _mm256_srli_epi16(a, 8)), one), 1);
+            const __m256i sb = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(_mm256_and_si256(b, low), _mm256_srli_epi16(b, 8)), one), 1);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), _mm256_permute4x64_epi64(_mm256_packus_epi16(sa, sb), 0xd8));
+        }
+        halveRowSSE2(row0 + 2*x, row1 + 2*x, out + x, width - x);
+    }
+    
+    /// unpacking and packing stay within 128 bit lanes, as in grayAVX2
+    __attribute__((target("avx2")))
+    inline __m256i mean4AVX2(__m256i a, __m256i b, __m256i c, __m256i d) {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i two = _mm256_set1_epi16(2);
+        const __m256i lo = _mm256_add_epi16(_mm256_add_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero)),
+                                            _mm256_add_epi16(_mm256_unpacklo_epi8(c, zero), _mm256_unpacklo_epi8(d, zero)));
+        const __m256i hi = _mm256_add_epi16(_mm256_add_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero)),
+                                            _mm256_add_epi16(_mm256_unpackhi_epi8(c, zero), _mm256_unpackhi_epi8(d, zero)));
+        return _mm256_packus_epi16(_mm256_srli_epi16(_mm256_add_epi16(lo, two), 2), _mm256_srli_epi16(_mm256_add_epi16(hi, two), 2));
+    }
+    
+    __attribute__((target("avx2")))
+    void demosaicRowAVX2(const uint8_t* up, const uint8_t* mid, const uint8_t* down, size_t x, size_t end,
+                         bool redRow, uint8_t* r, uint8_t* g, uint8_t* b) {
+        const __m256i evenColumn = _mm256_set1_epi16(static_cast<short>(x % 2u ? 0xff00 : 0x00ff));
+        for(; x + 32u <= end; x += 32u) {
+            const __m256i self = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mid + x));
+            const __m256i left = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mid + x - 1));
+            const __m256i right = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mid + x + 1));
+            const __m256i above = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(up + x));
+            const __m256i below = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(down + x));
+            const __m256i cross = mean4AVX2(left, right, above, below);
+            const __m256i diagonal = mean4AVX2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(up + x - 1)),
+                                               _mm256_loadu_si256(reinterpret_cast<const __m256i*>(up + x + 1)),
+                                               _mm256_loadu_si256(reinterpret_cast<const __m256i*>(down + x - 1)),
+                                               _mm256_loadu_si256(reinterpret_cast<const __m256i*>(down + x + 1)));
+            const __m256i horizontal = _mm256_avg_epu8(left, right);
+            const __m256i vertical = _mm256_avg_epu8(above, below);
+            __m256i vr, vg, vb;
+            if(redRow) {
+                vr = _mm256_blendv_epi8(horizontal, self, evenColumn);
+                vg = _mm256_blendv_epi8(self, cross, evenColumn);
+                vb = _mm256_blendv_epi8(vertical, diagonal, evenColumn);
+            } else {
+                vr = _mm256_blendv_epi8(diagonal, vertical, evenColumn);
+                vg = _mm256_blendv_epi8(cross, self, evenColumn);
+                vb = _mm256_blendv_epi8(self, horizontal, evenColumn);
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(r + x), vr);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(g + x), vg);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(b + x), vb);
+        }
+        demosaicRowSSE2(up, mid, down, x, end, redRow, r, g, b);
+    }
+    
+#endif
+    
+    struct kernels {
+        Isa isa;
+        void (*gray)(const uint8_t* r, const uint8_t* g, const uint8_t* b, uint8_t* y, size_t n);
+        void (*halveRow)(const uint8_t* row0, const uint8_t* row1, uint8_t* out, size_t width);
+        void (*demosaicRow)(const uint8_t* up, const uint8_t* mid, const uint8_t* down, size_t x, size_t end,
+                            bool redRow, uint8_t* r, uint8_t* g, uint8_t* b);
+    };
+    
+    const kernels scalarKernels = { Isa::Scalar, &grayScalar, &halveRowScalar, &demosaicRowScalar };
+#ifdef PROCESSING_X86
+    const kernels sse2Kernels = { Isa::SSE2, &graySSE2, &halveRowSSE2, &demosaicRowSSE2 };
+    const kernels avx2Kernels = { Isa::AVX2, &grayAVX2, &halveRowAVX2, &demosaicRowAVX2 };
+#endif
+    
+    bool supported(Isa isa) {
+#ifdef PROCESSING_X86
+        switch(isa) {
+            case Isa::AVX2: return __builtin_cpu_supports("avx2");
+            case Isa::SSE2: return __builtin_cpu_supports("sse2");
+            case Isa::Scalar: return true;
+        }
+#endif
+        return isa == Isa::Scalar;
+    }
+    
+    const kernels& kernelsFor(Isa isa) {
+#ifdef PROCESSING_X86
+        if(isa == Isa::AVX2 && supported(Isa::AVX2))
+            return avx2Kernels;
+        if(isa != Isa::Scalar && supported(Isa::SSE2))
+            return sse2Kernels;
+#endif
+        return scalarKernels;
+    }
+    
+    /// selectIsa() may switch the kernels while other threads process frames
+    std::atomic<const kernels*>& active() {
+        static std::atomic<const kernels*> selected{ &kernelsFor(Isa::AVX2) };
+        return selected;
+    }
+
+}
+
+Isa activeIsa() {
+    return active().load()->isa;
+}
+
+Isa selectIsa(Isa isa) {
+    const kernels& selected = kernelsFor(isa);
+    active() = &selected;
+    return selected.isa;
+}
+
+
+/// The interior rows go through the vector kernels; the border pixels are
+/// mirrored and interpolated one by one.
+std::shared_ptr<const image> demosaic(const picture& raw) {
+    const size_t w = raw.format().width, h = raw.format().height;
+    if(w < 2u || h < 2u)
+        throw std::invalid_argument("demosaic: frame of at least 2x2 pixels expected");
+    auto rgb = std::make_shared<image>(w, h, 3u);
+    uint8_t* const r = rgb->plane(0);
+    uint8_t* const g = rgb->plane(1);
+    uint8_t* const b = rgb->plane(2);
+    const uint8_t* src = raw.data();
+    auto at = [&](long x, long y) -> unsigned {
+        x = x < 0 ? 1 : (x >= static_cast<long>(w) ? static_cast<long>(w) - 2 : x);
+        y = y < 0 ? 1 : (y >= static_cast<long>(h) ? static_cast<long>(h) - 2 : y);
+        return src[y * w + x];
+    };
+    auto border = [&](long x, long y) {
+        const bayer_site s = { at(x, y), at(x-1, y), at(x+1, y), at(x, y-1), at(x, y+1),
+                               at(x-1, y-1), at(x+1, y-1), at(x-1, y+1), at(x+1, y+1) };
+        const size_t i = y * w + x;
+        interpolate(s, y % 2 == 0, x % 2 == 0, r[i], g[i], b[i]);
+    };
+    const auto demosaicRow = active().load()->demosaicRow;
+    for(size_t y = 0u; y < h; ++y) {
+        if(y == 0u || y == h - 1u) {
+            for(size_t x = 0u; x < w; ++x)
+                border(x, y);
+            continue;
+        }
+        const size_t row = y * w;
+        border(0, y);
+        demosaicRow(src + row - w, src + row, src + row + w, 1u, w - 1u, y % 2u == 0u, r + row, g + row, b + row);
+        border(w - 1u, y);
+    }
+    return rgb;
+}
+
+std::shared_ptr<const image> toGray(const image& rgb) {
+    if(rgb.channels != 3u)
+        throw std::invalid_argument("toGray: RGB image expected");
+    auto gray = std::make_shared<image>(rgb.width, rgb.height, 1u);
+    active().load()->gray(rgb.plane(0), rgb.plane(1), rgb.plane(2), gray->plane(0), rgb.width * rgb.height);
+    return gray;
+}
+
+std::shared_ptr<const image> downscale(const image& img, unsigned factor) {
+    if(factor == 4u)
+        return downscale(*downscale(img, 2u), 2u);
+    if(factor != 2u)
+        throw std::invalid_argument("downscale: factor 2 or 4 expected");
+    auto halved = std::make_shared<image>(img.width / 2u, img.height / 2u, img.channels);
+    const auto halveRow = active().load()->halveRow;
+    for(size_t c = 0u; c < img.channels; ++c) {
+        const uint8_t* src = img.plane(c);
+        uint8_t* dst = halved->plane(c);
+        for(size_t y = 0u; y < halved->height; ++y)
+            halveRow(src + 2u*y * img.width, src + (2u*y + 1u) * img.width, dst + y * halved->width, halved->width);
+    }
+    return halved;
+}
+
+std::shared_ptr<const image> crop(const image& img, roi region) {
+    if(region.x + region.width > img.width || region.y + region.height > img.height)
+        throw std::out_of_range("crop: region outside of the image");
+    auto cropped = std::make_shared<image>(region.width, region.height, img.channels);
+    for(size_t c = 0u; c < img.channels; ++c)
+        for(size_t y = 0u; y < region.height; ++y)
+            std::memcpy(cropped->plane(c) + y * region.width, img.plane(c) + (region.y + y) * img.width + region.x, region.width);
+    return cropped;
+}
+
+std::shared_ptr<const image> crop(const picture& raw, roi region) {
+    const size_t x0 = region.x & ~size_t(1u), y0 = region.y & ~size_t(1u);
+    const size_t x1 = std::min((region.x + region.width + 1u) & ~size_t(1u), raw.format().width);
+    const size_t y1 = std::min((region.y + region.height + 1u) & ~size_t(1u), raw.format().height);
+    if(region.x + region.width > raw.format().width || region.y + region.height > raw.format().height)
+        throw std::out_of_range("crop: region outside of the picture");
+    auto cropped = std::make_shared<image>(x1 - x0, y1 - y0, 1u);
+    for(size_t y = y0; y < y1; ++y)
+        std::memcpy(cropped->plane(0) + (y - y0) * cropped->width, raw.data() + y * raw.format().width + x0, cropped->width);
+    return cropped;
+}
+
+namespace {
+    /// four partial histograms avoid stalls on runs of equal pixels
+    std::array<uint32_t,256> histogram(const uint8_t* pixels, size_t n) {
+        std::array<std::array<uint32_t,256>,4> partial{};
+        size_t i = 0u;
+        for(; i + 4u <= n; i += 4u) {
+            ++partial[0][pixels[i]];
+            ++partial[1][pixels[i+1]];
+            ++partial[2][pixels[i+2]];
+            ++partial[3][pixels[i+3]];
+        }
+        for(; i < n; ++i)
+            ++partial[0][pixels[i]];
+        for(size_t v = 0u; v < 256u; ++v)
+            partial[0][v] += partial[1][v] + partial[2][v] + partial[3][v];
+        return partial[0];
+    }
+}
+
+std::array<uint32_t,256> histogram(const image& img, size_t channel) {
+    return histogram(img.plane(channel), img.width * img.height);
+}
+
+std::array<uint32_t,256> histogram(const picture& raw) {
+    return histogram(raw.data(), raw.size());
+}
+
+
+std::shared_ptr<const image> demosaicStage(std::shared_ptr<const picture> raw) {
+    return demosaic(*raw);
+}
+
+std::shared_ptr<const image> grayStage(std::shared_ptr<const image> rgb) {
+    return toGray(*rgb);
+}
+
+std::shared_ptr<const image> halveStage(std::shared_ptr<const image> img) {
+    return downscale(*img, 2u);
+}
+
+}
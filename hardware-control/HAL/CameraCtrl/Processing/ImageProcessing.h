@@ -0,0 +1,76 @@
+#pragma once
+#include <HAL/CameraCtrl/Interfaces/Picture.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/// 8 bit image with one (gray) or three (RGB) channels, stored as planes one
+/// after another.
+struct image {
+    size_t width = 0u;
+    size_t height = 0u;
+    size_t channels = 0u;
+    std::vector<uint8_t> pixels;
+    
+    image() = default;
+    
+    image(size_t width, size_t height, size_t channels)
+        : width(width), height(height), channels(channels), pixels(width * height * channels)
+    {}
+    
+    uint8_t* plane(size_t channel) { return pixels.data() + channel * width * height; }
+    
+    const uint8_t* plane(size_t channel) const { return pixels.data() + channel * width * height; }
+};
+
+/// region of interest
+struct roi {
+    size_t x, y, width, height;
+};
+
+
+/// Pre-processing of captured frames. The kernels for demosaicing, gray
+/// conversion and downscaling come in SSE2 and AVX2 variants; the best one
+/// the CPU supports is picked at startup. All variants give identical results.
+namespace Processing {
+
+    enum class Isa { Scalar, SSE2, AVX2 };
+    
+    /// the instruction set the kernels currently use
+    Isa activeIsa();
+    
+    /// use the given instruction set, or the best supported one below it;
+    /// returns the one selected
+    Isa selectIsa(Isa isa);
+    
+    /// bilinear interpolation of an RGGB Bayer frame to planar RGB; the border
+    /// pixels are mirrored. Throws std::invalid_argument for frames smaller than 2x2.
+    std::shared_ptr<const image> demosaic(const picture& raw);
+    
+    /// luma of an RGB image, (77 R + 150 G + 29 B) / 256
+    std::shared_ptr<const image> toGray(const image& rgb);
+    
+    /// averages blocks of 2x2 or 4x4 pixels; odd rows and columns at the border are dropped
+    std::shared_ptr<const image> downscale(const image& img, unsigned factor);
+    
+    std::shared_ptr<const image> crop(const image& img, roi region);
+    
+    /// the raw Bayer pixels of the region, as a one channel image; the region
+    /// is widened to even coordinates to keep the Bayer phase
+    std::shared_ptr<const image> crop(const picture& raw, roi region);
+    
+    std::array<uint32_t,256> histogram(const image& img, size_t channel = 0u);
+    
+    std::array<uint32_t,256> histogram(const picture& raw);
+    
+    
+    /// Stages for a Task chain; frames are handed on as shared immutable images.
+    std::shared_ptr<const image> demosaicStage(std::shared_ptr<const picture> raw);
+    
+    std::shared_ptr<const image> grayStage(std::shared_ptr<const image> rgb);
+    
+    std::shared_ptr<const image> halveStage(std::shared_ptr<const image> img);
+
+}
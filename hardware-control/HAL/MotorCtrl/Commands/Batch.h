@@ -0,0 +1,78 @@
+#pragma once
+#include <HAL/MotorCtrl/Interfaces/IMotorCtrlVisitors.h>
+#include <HAL/MotorCtrl/Commands/MoveToAbs.h>
+#include <HAL/MotorCtrl/Commands/MoveToRel.h>
+#include <HAL/MotorCtrl/Commands/RunVelocity.h>
+#include <HAL/MotorCtrl/Commands/FindHome.h>
+#include <iostream>
+#include <vector>
+
+namespace Motor {
+
+    /// Motion commands handed to a controller in one submission and run in
+    /// order. The result holds what each single command returned, up to and
+    /// including the first that failed: a batch stops at a non-zero result,
+    /// since the later moves assume the earlier ones were made.
+    struct Batch : MotorCtrlVisitorBase<Batch,std::vector<int>> {
+        struct step {
+            enum kind_t { MoveToAbs, MoveToRel, RunVelocity, FindHome } kind;
+            double value;
+        };
+        std::vector<step> steps;
+
+        void moveToAbs(int steps) { this->steps.push_back({ step::MoveToAbs, double(steps) }); }
+        void moveToRel(int steps) { this->steps.push_back({ step::MoveToRel, double(steps) }); }
+        void runVelocity(double velocity) { steps.push_back({ step::RunVelocity, velocity }); }
+        void findHome() { steps.push_back({ step::FindHome, 0.0 }); }
+    };
+
+    template <typename MCTRL>
+    std::vector<int> runBatch(MCTRL& mctrl, Batch& batch) {
+        std::vector<int> results;
+        results.reserve(batch.steps.size());
+        for(auto& s : batch.steps) {
+            if(!results.empty() && results.back() != 0)
+                break;
+            switch(s.kind) {
+                case Batch::step::MoveToAbs: {
+                    MoveToAbs cmd(static_cast<int>(s.value));
+                    results.push_back(visit<MCTRL,MoveToAbs>::call(mctrl, cmd));
+                    break;
+                }
+                case Batch::step::MoveToRel: {
+                    MoveToRel cmd(static_cast<int>(s.value));
+                    results.push_back(visit<MCTRL,MoveToRel>::call(mctrl, cmd));
+                    break;
+                }
+                case Batch::step::RunVelocity: {
+                    RunVelocity cmd(s.value);
+                    results.push_back(visit<MCTRL,RunVelocity>::call(mctrl, cmd));
+                    break;
+                }
+                case Batch::step::FindHome: {
+                    FindHome cmd;
+                    results.push_back(visit<MCTRL,FindHome>::call(mctrl, cmd));
+                    break;
+                }
+            }
+        }
+        return results;
+    }
+
+}
+
+template <> struct
+visit<CanOpenDS402MotorCtrl,Motor::Batch> {
+    static std::vector<int> call(CanOpenDS402MotorCtrl& mctrl, Motor::Batch& visitor) {
+        std::cout << "CanOpenDS402MotorCtrl: Batch("<<visitor.steps.size()<<")"<<std::endl;
+        return Motor::runBatch(mctrl, visitor);
+    }
+};
+
+template <> struct
+visit<ElmoWhistleMotorCtrl,Motor::Batch> {
+    static std::vector<int> call(ElmoWhistleMotorCtrl& mctrl, Motor::Batch& visitor) {
+        std::cout << "ElmoWhistleMotorCtrl: Batch("<<visitor.steps.size()<<")"<<std::endl;
+        return Motor::runBatch(mctrl, visitor);
+    }
+};
@@ -0,0 +1,169 @@
+#pragma once
+#include <TDD/forth.h>
+#include <HAL/MotorCtrl/Interfaces/IMotorCtrl.h>
+#include <HAL/MotorCtrl/Commands/Batch.h>
+#include <HAL/CameraCtrl/Interfaces/ICameraCtrl.h>
+#include <HAL/CameraCtrl/Commands/TakePicture.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// Forth words for the configured motors and cameras:
+///
+///     <prefix>move-abs     ( steps -- )     Motor::MoveToAbs
+///     <prefix>move-rel     ( steps -- )     Motor::MoveToRel
+///     <prefix>run-velocity ( velocity -- )  Motor::RunVelocity
+///     <prefix>find-home    ( -- )           Motor::FindHome
+///     <prefix>take-picture ( -- )           Camera::TakePicture, the picture goes to the sink
+///     sync                 ( -- )           submits the queued commands
+///
+/// Device words only queue their command. Consecutive commands for one
+/// device are submitted together, as one Motor::Batch or one
+/// Camera::TakePictures, when a word addresses another device, on sync and
+/// when run() returns. The words leave nothing on the stack, so queueing
+/// does not change what a script computes. Words defined in C++ that rely
+/// on the devices having moved have to flush() first.
+class
+device_words {
+public:
+    explicit device_words(forth::machine& machine);
+
+    device_words(const device_words&) = delete;
+
+    void bind(const std::string& prefix, std::shared_ptr<IMotorCtrl> motor);
+
+    void bind(const std::string& prefix, std::shared_ptr<ICameraCtrl> camera, std::function<void(picture)> sink);
+
+    /// runs p and submits what it queued; if p throws, its queued commands are dropped
+    void run(forth::program p);
+
+    /// runs the source once; its top-level code is not kept
+    void interpret(const std::string& source);
+
+    /// throws forth::error if a motor reports a non-zero result, after which
+    /// the rest of its batch is not run, or a camera has no free frame buffer
+    /// for a picture
+    void flush();
+
+    /// number of submissions to the devices so far
+    size_t submissions() const;
+
+private:
+    struct camera_binding {
+        std::shared_ptr<ICameraCtrl> camera;
+        std::function<void(picture)> sink;
+    };
+
+    forth::machine& machine;
+    std::vector<std::shared_ptr<IMotorCtrl>> motors;
+    std::vector<std::unique_ptr<camera_binding>> cameras;
+    IMotorCtrl* pendingMotor = nullptr;
+    Motor::Batch motorBatch;
+    camera_binding* pendingCamera = nullptr;
+    size_t pendingPictures = 0u;
+    size_t submitted = 0u;
+
+    Motor::Batch& queue(IMotorCtrl* motor);
+
+    void queue(camera_binding* camera);
+
+    void discard();
+};
+
+
+
+inline device_words::device_words(forth::machine& machine)
+: machine(machine)
+{
+    machine.define("sync", [this](forth::machine&) { flush(); });
+}
+
+inline void device_words::bind(const std::string& prefix, std::shared_ptr<IMotorCtrl> motor) {
+    IMotorCtrl* m = motor.get();
+    motors.push_back(std::move(motor));
+    machine.define(prefix + "move-abs", [this,m](forth::machine& vm) { queue(m).moveToAbs(vm.pop()); });
+    machine.define(prefix + "move-rel", [this,m](forth::machine& vm) { queue(m).moveToRel(vm.pop()); });
+    machine.define(prefix + "run-velocity", [this,m](forth::machine& vm) { queue(m).runVelocity(vm.pop()); });
+    machine.define(prefix + "find-home", [this,m](forth::machine&) { queue(m).findHome(); });
+}
+
+inline void device_words::bind(const std::string& prefix, std::shared_ptr<ICameraCtrl> camera, std::function<void(picture)> sink) {
+    cameras.emplace_back(new camera_binding { std::move(camera), std::move(sink) });
+    camera_binding* c = cameras.back().get();
+    machine.define(prefix + "take-picture", [this,c](forth::machine&) { queue(c); });
+}
+
+inline Motor::Batch& device_words::queue(IMotorCtrl* motor) {
+    if(pendingMotor != motor)
+        flush();
+    pendingMotor = motor;
+    return motorBatch;
+}
+
+inline void device_words::queue(camera_binding* camera) {
+    if(pendingCamera != camera)
+        flush();
+    pendingCamera = camera;
+    ++pendingPictures;
+}
+
+inline void device_words::run(forth::program p) {
+    try {
+        machine.run(p);
+    } catch(...) {
+        discard();
+        throw;
+    }
+    flush();
+}
+
+inline void device_words::interpret(const std::string& source) {
+    const forth::program p = machine.compile(source);
+    try {
+        run(p);
+    } catch(...) {
+        machine.forget(p);
+        throw;
+    }
+    machine.forget(p);
+}
+
+inline void device_words::flush() {
+    if(pendingMotor) {
+        IMotorCtrl* motor = pendingMotor;
+        pendingMotor = nullptr;
+        struct clear_steps {
+            Motor::Batch& batch;
+            ~clear_steps() { batch.steps.clear(); }
+        } clear { motorBatch };
+        ++submitted;
+        const auto results = motor->accept(motorBatch);
+        if(!results.empty() && results.back() != 0)
+            throw forth::error("motor command " + std::to_string(results.size() - 1u) + " of a batch failed with " + std::to_string(results.back()));
+    }
+    if(pendingCamera) {
+        camera_binding* c = pendingCamera;
+        Camera::TakePictures cmd(pendingPictures, [c](picture pic) { c->sink(std::move(pic)); });
+        ICameraCtrl& camera = *c->camera;
+        pendingCamera = nullptr;
+        pendingPictures = 0u;
+        ++submitted;
+        try {
+            camera.accept(cmd);
+        } catch(const Camera::error& e) {
+            throw forth::error(e.what());
+        }
+    }
+}
+
+inline void device_words::discard() {
+    pendingMotor = nullptr;
+    motorBatch.steps.clear();
+    pendingCamera = nullptr;
+    pendingPictures = 0u;
+}
+
+inline size_t device_words::submissions() const {
+    return submitted;
+}
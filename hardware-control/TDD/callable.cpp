@@ -1,13 +1,26 @@
 #include <catch.h>
 #include <cmath>
+#include <algorithm>
 #include <iostream>
 
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
 #include <sstream>
 #include <utility>
+#include <numeric>
+#include <future>
+#include <chrono>
+#include <functional>
+#include <tuple>
+#include <atomic>
+#include <TDD/span.h>
+#include <HAL/CameraCtrl/Processing/ImageProcessing.h>
 
 
 
@@ -273,24 +286,504 @@ class TestThreadExecutor : public IExecutor {
     }
 };
 
+/// Fixed number of worker threads sharing one FIFO task queue.
+/// Pending tasks are drained before the destructor joins the workers.
+class ThreadPoolExecutor : public IExecutor {
+    struct Queue {
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::deque<Delegate<void()>> tasks;
+        bool stopping = false;
+    };
+    
+    /// shared with the workers: a task may hold the last reference to the pool,
+    /// in which case the pool is destroyed on one of its own workers
+    std::shared_ptr<Queue> queue;
+    std::vector<std::thread> workers;
+
+    virtual void execute_impl(Delegate<void()> executable) {
+        {
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            queue->tasks.push_back(std::move(executable));
+        }
+        queue->cond.notify_one();
+    }
+
+    static void work(const std::shared_ptr<Queue>& queue) {
+        for(;;) {
+            std::unique_lock<std::mutex> lock(queue->mutex);
+            queue->cond.wait(lock, [&]{ return queue->stopping || !queue->tasks.empty(); });
+            if(queue->tasks.empty())
+                return;
+            auto task = std::move(queue->tasks.front());
+            queue->tasks.pop_front();
+            lock.unlock();
+            task();
+        }
+    }
+
+public:
+    explicit ThreadPoolExecutor(size_t threads = std::max(1u, std::thread::hardware_concurrency()))
+        : queue(std::make_shared<Queue>())
+    {
+        for(size_t i = 0u; i < threads; ++i)
+            workers.emplace_back([q = queue]{ work(q); });
+    }
+
+    ~ThreadPoolExecutor() {
+        {
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            queue->stopping = true;
+        }
+        queue->cond.notify_all();
+        for(auto& worker : workers) {
+            if(worker.get_id() == std::this_thread::get_id())
+                worker.detach();
+            else
+                worker.join();
+        }
+    }
+};
+
+/// Serial queue on top of another executor: tasks given to one strand run one
+/// after the other in FIFO order, while different strands sharing the same
+/// underlying executor run in parallel. At most one drain task per strand is
+/// ever pending on the underlying executor.
+class StrandExecutor : public IExecutor {
+    struct State {
+        std::shared_ptr<IExecutor> target;
+        std::mutex mutex;
+        std::deque<Delegate<void()>> tasks;
+        bool scheduled = false;
+
+        State(std::shared_ptr<IExecutor> target) : target(std::move(target)) {}
+    };
+
+    /// shared with the drain task, so the strand may die while tasks are still pending
+    std::shared_ptr<State> state;
+
+    static void post(const std::shared_ptr<State>& state) {
+        auto s = state;
+        state->target->execute(Delegate<void()>::create(forward_shared([s]{ drain(s); })));
+    }
+
+    /// a task that throws ends its drain; the remaining tasks get a new one
+    static void drain(const std::shared_ptr<State>& state) {
+        for(;;) {
+            Delegate<void()> task = [&]{
+                std::lock_guard<std::mutex> lock(state->mutex);
+                auto front = std::move(state->tasks.front());
+                state->tasks.pop_front();
+                return front;
+            }();
+            try {
+                task();
+            } catch(...) {
+                resume(state);
+                throw;
+            }
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if(state->tasks.empty()) {
+                state->scheduled = false;
+                return;
+            }
+        }
+    }
+
+    static void resume(const std::shared_ptr<State>& state) {
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if(state->tasks.empty()) {
+                state->scheduled = false;
+                return;
+            }
+        }
+        post(state);
+    }
+
+    virtual void execute_impl(Delegate<void()> executable) {
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->tasks.push_back(std::move(executable));
+            if(state->scheduled)
+                return;
+            state->scheduled = true;
+        }
+        post(state);
+    }
+
+public:
+    explicit StrandExecutor(std::shared_ptr<IExecutor> target)
+        : state(std::make_shared<State>(std::move(target)))
+    {}
+};
+
+
+/// Element type of the batches delivered to batched observers: the plain event
+/// type for single-argument dispatchers, a tuple of the arguments otherwise.
+template <typename...Args> struct
+batch_event {
+    using type = std::tuple<std::decay_t<Args>...>;
+};
+
+template <typename Arg> struct
+batch_event<Arg> {
+    using type = std::decay_t<Arg>;
+};
+
+template <typename...Args> using
+batch_event_t = typename batch_event<Args...>::type;
+
+
+/// Accumulates the events of one batched observer on the producer side and
+/// hands them to the observer's executor as one contiguous batch, either when
+/// maxBatch events have been collected or when the window of the oldest
+/// pending event has elapsed.
+template <typename...Args> class
+BatchCollector {
+public:
+    using event_type = batch_event_t<Args...>;
+    using clock = std::chrono::steady_clock;
+
+private:
+    Delegate<void(span<const event_type>)> observer;
+    std::shared_ptr<IExecutor> executor;
+    const size_t maxBatch;
+    const clock::duration window;
+    std::function<void()> onBatchOpened;
+
+    std::mutex mutex;
+    std::vector<event_type> pending;
+    clock::time_point pendingDeadline = clock::time_point::max();
+
+    std::vector<event_type> takePending() {
+        std::vector<event_type> batch;
+        batch.reserve(maxBatch);
+        batch.swap(pending);
+        pendingDeadline = clock::time_point::max();
+        return batch;
+    }
+
+    void deliver(std::vector<event_type> batch) {
+        if(batch.empty())
+            return;
+        auto events = forward_shared(std::move(batch));
+        auto obs = observer;
+        executor->execute(Delegate<void()>::create(forward_shared([obs,events]{
+            obs(span<const event_type>(events->data(), events->size()));
+        })));
+    }
+
+public:
+    BatchCollector(Delegate<void(span<const event_type>)> observer,
+                   std::shared_ptr<IExecutor> executor,
+                   size_t maxBatch,
+                   clock::duration window,
+                   std::function<void()> onBatchOpened)
+        : observer(std::move(observer))
+        , executor(std::move(executor))
+        , maxBatch(std::max<size_t>(1u, maxBatch))
+        , window(window)
+        , onBatchOpened(std::move(onBatchOpened))
+    {
+        pending.reserve(this->maxBatch);
+    }
+
+    void operator() (const Args&... args) {
+        std::vector<event_type> full;
+        bool opened = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(pending.empty() && window != clock::duration::zero()) {
+                pendingDeadline = clock::now() + window;
+                opened = true;
+            }
+            pending.emplace_back(args...);
+            if(pending.size() >= maxBatch)
+                full = takePending();
+        }
+        if(!full.empty())
+            deliver(std::move(full));
+        else if(opened && onBatchOpened)
+            onBatchOpened();
+    }
+
+    clock::time_point deadline() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pendingDeadline;
+    }
+
+    void flushIfDue(clock::time_point now) {
+        std::vector<event_type> due;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(pendingDeadline <= now)
+                due = takePending();
+        }
+        deliver(std::move(due));
+    }
+
+    void flush() {
+        std::vector<event_type> rest;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            rest = takePending();
+        }
+        deliver(std::move(rest));
+    }
+};
+
+
+/// One timer thread per Dispatcher that closes the windows of its batched
+/// observers. Only created once the first observer with a window is attached.
+template <typename...Args> class
+BatchFlusher {
+    using clock = std::chrono::steady_clock;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool stopping = false;
+    std::vector<std::shared_ptr<BatchCollector<Args...>>> collectors;
+    std::thread thread;
+
+    /// Flushes without holding the mutex: an inline executor runs the observer
+    /// right here, and an observer that publishes again opens a batch and
+    /// calls wake(). Deadlines are read again after each round, so a wake()
+    /// in between is not lost.
+    void run() {
+        std::vector<std::shared_ptr<BatchCollector<Args...>>> due;
+        std::unique_lock<std::mutex> lock(mutex);
+        while(!stopping) {
+            auto next = clock::time_point::max();
+            for(const auto& collector : collectors)
+                next = std::min(next, collector->deadline());
+            if(next == clock::time_point::max())
+                cond.wait(lock);
+            else
+                cond.wait_until(lock, next);
+            if(stopping)
+                break;
+            due = collectors;
+            lock.unlock();
+            const auto now = clock::now();
+            for(const auto& collector : due)
+                collector->flushIfDue(now);
+            due.clear();
+            lock.lock();
+        }
+    }
+
+public:
+    BatchFlusher()
+        : thread([this]{ run(); })
+    {}
+
+    ~BatchFlusher() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cond.notify_one();
+        thread.join();
+    }
+
+    void add(std::shared_ptr<BatchCollector<Args...>> collector) {
+        std::lock_guard<std::mutex> lock(mutex);
+        collectors.push_back(std::move(collector));
+    }
+
+    /// a batch has been opened, so the earliest deadline may have changed
+    void wake() {
+        std::lock_guard<std::mutex> lock(mutex);
+        cond.notify_one();
+    }
+};
+
+
+/// What a bounded observer queue does with a new event when it is full.
+enum class OverflowPolicy {
+    Block,          ///< the producer waits until the observer has caught up
+    DropOldest,     ///< the oldest pending event is discarded
+    DropNewest,     ///< the new event is discarded
+    KeepLatest,     ///< the new event replaces the newest pending one (conflation)
+};
+
+/// Counters of a bounded observer queue, updated while the dispatcher runs.
+struct BoundedQueueStats {
+    std::atomic<size_t> enqueued{0u};
+    std::atomic<size_t> delivered{0u};
+    std::atomic<size_t> blocked{0u};         ///< producer had to wait (Block)
+    std::atomic<size_t> droppedOldest{0u};   ///< DropOldest
+    std::atomic<size_t> droppedNewest{0u};   ///< DropNewest
+    std::atomic<size_t> conflated{0u};       ///< KeepLatest
+};
+
+
+/// Per-observer queue of at most 'capacity' pending events in front of the
+/// observer's executor. The queue is drained by a single task at a time, so
+/// an observer sees its events in order and never has more than one task
+/// pending on the executor, no matter how far it falls behind.
+/// With OverflowPolicy::Block, an observer must not publish into its own
+/// dispatcher, since it would wait for itself.
+template <typename...Args> class
+BoundedObserver {
+    using event_type = std::tuple<std::decay_t<Args>...>;
+
+    struct State {
+        Delegate<void(Args...)> observer;
+        std::shared_ptr<IExecutor> executor;
+        const size_t capacity;
+        const OverflowPolicy policy;
+        std::shared_ptr<BoundedQueueStats> stats;
+
+        std::mutex mutex;
+        std::condition_variable spaceAvailable;
+        std::deque<event_type> queue;
+        bool scheduled = false;
+
+        State(Delegate<void(Args...)> observer, std::shared_ptr<IExecutor> executor, size_t capacity, OverflowPolicy policy)
+            : observer(std::move(observer))
+            , executor(std::move(executor))
+            , capacity(std::max<size_t>(1u, capacity))
+            , policy(policy)
+            , stats(std::make_shared<BoundedQueueStats>())
+        {}
+    };
+
+    std::shared_ptr<State> state;
+
+    template <size_t...I>
+    static void call(const Delegate<void(Args...)>& observer, event_type& event, std::index_sequence<I...>) {
+        observer(std::get<I>(event)...);
+    }
+
+    static void post(const std::shared_ptr<State>& state) {
+        auto s = state;
+        state->executor->execute(Delegate<void()>::create(forward_shared([s]{ drain(s); })));
+    }
+
+    /// an observer that throws ends the drain; the remaining events get a new one
+    static void drain(const std::shared_ptr<State>& state) {
+        for(;;) {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            if(state->queue.empty()) {
+                state->scheduled = false;
+                return;
+            }
+            auto event = std::move(state->queue.front());
+            state->queue.pop_front();
+            lock.unlock();
+            state->spaceAvailable.notify_one();
+            try {
+                call(state->observer, event, std::index_sequence_for<Args...>{});
+            } catch(...) {
+                resume(state);
+                throw;
+            }
+            ++state->stats->delivered;
+        }
+    }
+
+    static void resume(const std::shared_ptr<State>& state) {
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if(state->queue.empty()) {
+                state->scheduled = false;
+                return;
+            }
+        }
+        post(state);
+    }
+
+public:
+    BoundedObserver(Delegate<void(Args...)> observer, std::shared_ptr<IExecutor> executor, size_t capacity, OverflowPolicy policy)
+        : state(std::make_shared<State>(std::move(observer), std::move(executor), capacity, policy))
+    {}
+
+    std::shared_ptr<const BoundedQueueStats> stats() const {
+        return state->stats;
+    }
+
+    void operator() (const Args&... args) {
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            auto& stats = *state->stats;
+            if(state->queue.size() >= state->capacity) {
+                switch(state->policy) {
+                    case OverflowPolicy::Block:
+                        ++stats.blocked;
+                        state->spaceAvailable.wait(lock, [&]{ return state->queue.size() < state->capacity; });
+                        break;
+                    case OverflowPolicy::DropOldest:
+                        state->queue.pop_front();
+                        ++stats.droppedOldest;
+                        break;
+                    case OverflowPolicy::DropNewest:
+                        ++stats.droppedNewest;
+                        return;
+                    case OverflowPolicy::KeepLatest:
+                        state->queue.back() = event_type(args...);
+                        ++stats.conflated;
+                        return;
+                }
+            }
+            state->queue.emplace_back(args...);
+            ++stats.enqueued;
+            if(state->scheduled)
+                return;
+            state->scheduled = true;
+        }
+        post(state);
+    }
+};
+
 
 template <typename...Args> class
 Dispatcher;
 
+template <typename...Args>
+struct batch_dsl_temp;
+
+template <typename...Args>
+struct bounded_dsl_temp;
+
 template <typename...Args>
 struct dispatch_dsl_temp {
+    friend struct batch_dsl_temp<Args...>;
+    friend struct bounded_dsl_temp<Args...>;
     Dispatcher<Args...>& dispatcher;
     std::shared_ptr<IExecutor> executor;
+    bool ownStrand = false;
+    
+    /// every observer attached through the returned DSL object gets a strand of
+    /// its own on top of the executor, i.e. it sees the events in order
+    dispatch_dsl_temp strand() const {
+        return { dispatcher, executor, true };
+    }
+    
+    /// observers attached through the returned DSL object receive the events in
+    /// batches of up to maxBatch events; with a non-zero window, a batch is also
+    /// delivered once its oldest event has waited for that long
+    batch_dsl_temp<Args...> batched(size_t maxBatch, std::chrono::steady_clock::duration window = std::chrono::steady_clock::duration::zero()) const {
+        return { *this, maxBatch, window };
+    }
+    
+    /// observers attached through the returned DSL object get a queue of at most
+    /// 'capacity' pending events in front of the executor; 'policy' decides what
+    /// happens to the producer or to the events when that queue is full
+    bounded_dsl_temp<Args...> bounded(size_t capacity, OverflowPolicy policy) const {
+        return { *this, capacity, policy };
+    }
     
     template <typename Ret, Ret(*GlobalFn)(Args...)>
     void to() {
-        auto p = std::make_pair(Delegate<Ret(Args...)>::template create<GlobalFn>(), executor);
+        auto p = std::make_pair(Delegate<Ret(Args...)>::template create<GlobalFn>(), observerExecutor());
         dispatcher.observers.emplace(std::move(p));
     }
 
     template <typename Ret>
     void to(Delegate<Ret(Args...)> delegate) {
-        auto p = std::make_pair(delegate, executor);
+        auto p = std::make_pair(delegate, observerExecutor());
         dispatcher.observers.emplace(std::move(p));
     }
 
@@ -300,6 +793,49 @@ struct dispatch_dsl_temp {
         to(Delegate<Ret(Args...)>::create(forward_shared(std::forward<T>(fn))));
     }
     
+private:
+    std::shared_ptr<IExecutor> observerExecutor() const {
+        if(ownStrand)
+            return std::make_shared<StrandExecutor>(executor);
+        return executor;
+    }
+};
+
+
+template <typename...Args>
+struct batch_dsl_temp {
+    using event_type = batch_event_t<Args...>;
+    
+    dispatch_dsl_temp<Args...> base;
+    size_t maxBatch;
+    std::chrono::steady_clock::duration window;
+    
+    void to(Delegate<void(span<const event_type>)> delegate) {
+        base.dispatcher.addBatched(std::move(delegate), base.observerExecutor(), maxBatch, window);
+    }
+    
+    template <typename T>
+    void to(T&& fn) {
+        to(Delegate<void(span<const event_type>)>::create(forward_shared(std::forward<T>(fn))));
+    }
+};
+
+
+template <typename...Args>
+struct bounded_dsl_temp {
+    dispatch_dsl_temp<Args...> base;
+    size_t capacity;
+    OverflowPolicy policy;
+    
+    /// the returned counters stay valid after the dispatcher is gone
+    std::shared_ptr<const BoundedQueueStats> to(Delegate<void(Args...)> delegate) {
+        return base.dispatcher.addBounded(std::move(delegate), base.executor, capacity, policy);
+    }
+    
+    template <typename T>
+    std::shared_ptr<const BoundedQueueStats> to(T&& fn) {
+        return to(Delegate<void(Args...)>::create(forward_shared(std::forward<T>(fn))));
+    }
 };
 
 
@@ -312,16 +848,54 @@ Dispatcher {
         }
     };
     friend class dispatch_dsl_temp<Args...>;
+    friend struct batch_dsl_temp<Args...>;
+    friend struct bounded_dsl_temp<Args...>;
     using delegate_type = Delegate<void(Args...)>;
     std::unordered_map<delegate_type,std::shared_ptr<IExecutor>, DelegateHash> observers;
+    std::vector<std::shared_ptr<BatchCollector<Args...>>> batchedObservers;
+    std::shared_ptr<BatchFlusher<Args...>> flusher;
+    std::vector<BoundedObserver<Args...>> boundedObservers;
+    
+    std::shared_ptr<const BoundedQueueStats> addBounded(Delegate<void(Args...)> delegate,
+                                                        std::shared_ptr<IExecutor> executor,
+                                                        size_t capacity,
+                                                        OverflowPolicy policy)
+    {
+        boundedObservers.emplace_back(std::move(delegate), std::move(executor), capacity, policy);
+        return boundedObservers.back().stats();
+    }
+    
+    void addBatched(Delegate<void(span<const batch_event_t<Args...>>)> delegate,
+                    std::shared_ptr<IExecutor> executor,
+                    size_t maxBatch,
+                    std::chrono::steady_clock::duration window)
+    {
+        std::function<void()> onBatchOpened;
+        if(window != std::chrono::steady_clock::duration::zero()) {
+            if(!flusher)
+                flusher = std::make_shared<BatchFlusher<Args...>>();
+            onBatchOpened = [f = flusher.get()]{ f->wake(); };
+        }
+        const bool windowed = static_cast<bool>(onBatchOpened);
+        auto collector = std::make_shared<BatchCollector<Args...>>(std::move(delegate), std::move(executor), maxBatch, window, std::move(onBatchOpened));
+        if(windowed)
+            flusher->add(collector);
+        batchedObservers.push_back(std::move(collector));
+    }
+    
 public:
     Dispatcher()
         : sharedState(std::make_shared<SharedState>(this))
     {}
     
+    /// Waits for producers that are still inside an input() delegate. Must
+    /// therefore not be called from an observer running on a producer thread.
     ~Dispatcher() {
-        std::lock_guard<std::mutex> lock(sharedState->mutex);
         sharedState->parent = nullptr;
+        while(sharedState->activeInputs != 0u)
+            std::this_thread::yield();
+        flusher = nullptr;
+        flush();
     }
 
     auto via(std::shared_ptr<IExecutor> executor) {
@@ -343,11 +917,26 @@ public:
             }));
             executor->execute(std::move(task));
         }
+        for(const auto& collector : batchedObservers)
+            (*collector)(args...);
+        for(auto& bounded : boundedObservers)
+            bounded(args...);
     }
     
+    /// delivers the pending events of all batched observers right away
+    void flush() {
+        for(const auto& collector : batchedObservers)
+            collector->flush();
+    }
+    
+    /// Liveness of the dispatcher as seen by its input() delegates. A producer
+    /// announces itself in activeInputs before it looks at parent, and the
+    /// destructor clears parent before it waits for activeInputs to drain, so
+    /// either the producer sees nullptr or the destructor sees the producer.
+    /// Concurrent producers only touch the counter and never wait for each other.
     struct SharedState {
-        Dispatcher* parent;
-        std::mutex mutex;
+        std::atomic<Dispatcher*> parent;
+        std::atomic<size_t> activeInputs{0u};
         SharedState(Dispatcher* parent) : parent(std::move(parent)) {}
     };
     std::shared_ptr<SharedState> sharedState;
@@ -358,8 +947,13 @@ public:
             std::shared_ptr<SharedState> sharedState;
             InputDelegate(std::shared_ptr<SharedState> sharedState) : sharedState(sharedState) {}
             void operator() (Args...args) {
-                std::lock_guard<std::mutex> lock(sharedState->mutex);
-                if(const auto parent = sharedState->parent)
+                struct ActiveInput {
+                    std::atomic<size_t>& counter;
+                    ActiveInput(std::atomic<size_t>& counter) : counter(counter) { ++counter; }
+                    ~ActiveInput() { --counter; }
+                } active(sharedState->activeInputs);
+                
+                if(const auto parent = sharedState->parent.load())
                     (*parent)(args...);
                 else
                     throw std::exception();
@@ -462,7 +1056,7 @@ public:
 template <typename...Args>
 class Task<void(Args...)> {
     Delegate<void(Args...)> delegateIn;
-    Dispatcher<> dispatcherOut;
+    mutable Dispatcher<> dispatcherOut;
     Delegate<void(Args...)> delegate;
     
 public:
@@ -475,7 +1069,7 @@ public:
     {
     }
     
-    Dispatcher<void>& output() const { return dispatcherOut; }
+    Dispatcher<>& output() const { return dispatcherOut; }
     Delegate<void(Args...)> input() const { return delegateIn; }
 };
 
@@ -535,4 +1129,342 @@ TEST_CASE("Delegetion","test1") {
     //dispatch = nullptr;
     input(113241234,4444.444);
     
-}
\ No newline at end of file
+}
+
+TEST_CASE("StrandExecutor runs the tasks of one strand in order","[executor]") {
+    auto pool = std::make_shared<ThreadPoolExecutor>(4);
+    const int N = 1000;
+    std::vector<int> seenA, seenB;
+    std::promise<void> doneA, doneB;
+    {
+        StrandExecutor strandA(pool), strandB(pool);
+        for(int i = 0; i < N; ++i) {
+            strandA.execute(Delegate<void()>::create([&seenA,&doneA,i,N]{
+                seenA.push_back(i);
+                if(i == N-1) doneA.set_value();
+            }));
+            strandB.execute(Delegate<void()>::create([&seenB,&doneB,i,N]{
+                seenB.push_back(i);
+                if(i == N-1) doneB.set_value();
+            }));
+        }
+    }
+    doneA.get_future().wait();
+    doneB.get_future().wait();
+    
+    std::vector<int> expected(N);
+    std::iota(expected.begin(), expected.end(), 0);
+    REQUIRE(seenA == expected);
+    REQUIRE(seenB == expected);
+}
+
+
+TEST_CASE("Dispatcher delivers events in order to observers on their own strand","[executor][dispatcher]") {
+    auto pool = std::make_shared<ThreadPoolExecutor>(4);
+    const int N = 500;
+    std::vector<int> seen1, seen2;
+    std::promise<void> done1, done2;
+    
+    Dispatcher<int> dispatch;
+    auto viaStrand = dispatch.via(pool).strand();
+    viaStrand.to([&seen1,&done1,N](int i){
+        seen1.push_back(i);
+        if(i == N-1) done1.set_value();
+    });
+    viaStrand.to([&seen2,&done2,N](int i){
+        seen2.push_back(i);
+        if(i == N-1) done2.set_value();
+    });
+    
+    for(int i = 0; i < N; ++i)
+        dispatch(i);
+    done1.get_future().wait();
+    done2.get_future().wait();
+    
+    std::vector<int> expected(N);
+    std::iota(expected.begin(), expected.end(), 0);
+    REQUIRE(seen1 == expected);
+    REQUIRE(seen2 == expected);
+}
+
+
+TEST_CASE("Batched observers receive the events in contiguous batches","[dispatcher][batch]") {
+    auto immediate = std::make_shared<ImmediateExecutor>();
+    std::vector<std::vector<int>> batches;
+    
+    Dispatcher<int> dispatch;
+    dispatch.via(immediate).batched(4).to([&batches](span<const int> events){
+        batches.emplace_back(events.begin(), events.end());
+    });
+    
+    for(int i = 0; i < 10; ++i)
+        dispatch(i);
+    
+    WHEN("the size threshold is reached") {
+        THEN("a full batch is delivered per threshold") {
+            REQUIRE(batches.size() == 2u);
+            REQUIRE(batches[0] == std::vector<int>({0,1,2,3}));
+            REQUIRE(batches[1] == std::vector<int>({4,5,6,7}));
+        }
+    }
+    
+    WHEN("the dispatcher is flushed") {
+        dispatch.flush();
+        THEN("the remaining events are delivered as a partial batch") {
+            REQUIRE(batches.size() == 3u);
+            REQUIRE(batches[2] == std::vector<int>({8,9}));
+        }
+    }
+}
+
+
+TEST_CASE("Batched observers of multi-argument dispatchers receive tuples","[dispatcher][batch]") {
+    auto immediate = std::make_shared<ImmediateExecutor>();
+    std::vector<std::tuple<int,float>> received;
+    {
+        Dispatcher<int,float> dispatch;
+        dispatch.via(immediate).batched(100).to([&received](span<const std::tuple<int,float>> events){
+            received.insert(received.end(), events.begin(), events.end());
+        });
+        dispatch(1, 1.5f);
+        dispatch(2, 2.5f);
+        REQUIRE(received.empty());
+    }
+    THEN("pending events are delivered when the dispatcher is destroyed") {
+        const std::vector<std::tuple<int,float>> expected{ std::make_tuple(1,1.5f), std::make_tuple(2,2.5f) };
+        REQUIRE(received == expected);
+    }
+}
+
+
+TEST_CASE("Batched observers receive a partial batch when the time window closes","[dispatcher][batch]") {
+    auto pool = std::make_shared<ThreadPoolExecutor>(2);
+    std::promise<std::vector<int>> batch;
+    
+    Dispatcher<int> dispatch;
+    dispatch.via(pool).batched(1000, std::chrono::milliseconds(20)).to([&batch](span<const int> events){
+        batch.set_value(std::vector<int>(events.begin(), events.end()));
+    });
+    
+    dispatch(1);
+    dispatch(2);
+    dispatch(3);
+    
+    auto received = batch.get_future();
+    REQUIRE(received.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+    REQUIRE(received.get() == std::vector<int>({1,2,3}));
+}
+
+
+TEST_CASE("Batched observers on an immediate executor may publish again when the window closes","[dispatcher][batch]") {
+    auto immediate = std::make_shared<ImmediateExecutor>();
+    std::vector<std::vector<int>> batches;
+    std::promise<void> done;
+    
+    Dispatcher<int> dispatch;
+    dispatch.via(immediate).batched(1000, std::chrono::milliseconds(5)).to([&](span<const int> events){
+        batches.emplace_back(events.begin(), events.end());
+        if(batches.size() == 1u)
+            dispatch(events[0] + 100);
+        else
+            done.set_value();
+    });
+    
+    dispatch(1);
+    
+    auto republished = done.get_future();
+    REQUIRE(republished.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+    REQUIRE(batches == std::vector<std::vector<int>>({{1},{101}}));
+}
+
+
+/// keeps the tasks until the test runs them, i.e. an observer that has stalled
+class ManualExecutor : public IExecutor {
+    virtual void execute_impl(Delegate<void()> executable) {
+        tasks.push_back(std::move(executable));
+    }
+public:
+    std::deque<Delegate<void()>> tasks;
+    
+    void runAll() {
+        while(!tasks.empty()) {
+            auto task = std::move(tasks.front());
+            tasks.pop_front();
+            task();
+        }
+    }
+};
+
+
+TEST_CASE("Bounded observers apply their overflow policy when they fall behind","[dispatcher][bounded]") {
+    auto stalled = std::make_shared<ManualExecutor>();
+    std::vector<int> seen;
+    Dispatcher<int> dispatch;
+    
+    auto publish = [&]{
+        for(int i = 0; i < 5; ++i)
+            dispatch(i);
+        REQUIRE(stalled->tasks.size() == 1u);
+        stalled->runAll();
+    };
+    
+    WHEN("the oldest events are dropped") {
+        auto stats = dispatch.via(stalled).bounded(3, OverflowPolicy::DropOldest).to([&seen](int i){ seen.push_back(i); });
+        publish();
+        THEN("the observer receives the newest events") {
+            REQUIRE(seen == std::vector<int>({2,3,4}));
+            REQUIRE(stats->droppedOldest == 2u);
+            REQUIRE(stats->delivered == 3u);
+        }
+    }
+    
+    WHEN("the newest events are dropped") {
+        auto stats = dispatch.via(stalled).bounded(3, OverflowPolicy::DropNewest).to([&seen](int i){ seen.push_back(i); });
+        publish();
+        THEN("the observer receives the oldest events") {
+            REQUIRE(seen == std::vector<int>({0,1,2}));
+            REQUIRE(stats->droppedNewest == 2u);
+            REQUIRE(stats->delivered == 3u);
+        }
+    }
+    
+    WHEN("only the latest value is kept") {
+        auto stats = dispatch.via(stalled).bounded(1, OverflowPolicy::KeepLatest).to([&seen](int i){ seen.push_back(i); });
+        publish();
+        THEN("the observer receives the latest value only") {
+            REQUIRE(seen == std::vector<int>({4}));
+            REQUIRE(stats->conflated == 4u);
+            REQUIRE(stats->enqueued == 1u);
+        }
+    }
+}
+
+
+TEST_CASE("A strand goes on after one of its tasks throws","[executor]") {
+    auto manual = std::make_shared<ManualExecutor>();
+    StrandExecutor strand(manual);
+    std::vector<int> seen;
+    strand.execute(Delegate<void()>::create([&seen]{ seen.push_back(1); }));
+    strand.execute(Delegate<void()>::create([]{ throw std::runtime_error("task failed"); }));
+    strand.execute(Delegate<void()>::create([&seen]{ seen.push_back(3); }));
+    REQUIRE(manual->tasks.size() == 1u);
+    
+    REQUIRE_THROWS_AS(manual->runAll(), std::runtime_error);
+    REQUIRE(seen == std::vector<int>({1}));
+    manual->runAll();
+    REQUIRE(seen == std::vector<int>({1,3}));
+    
+    strand.execute(Delegate<void()>::create([&seen]{ seen.push_back(4); }));
+    manual->runAll();
+    REQUIRE(seen == std::vector<int>({1,3,4}));
+}
+
+
+TEST_CASE("A bounded observer goes on after it throws","[dispatcher][bounded]") {
+    auto manual = std::make_shared<ManualExecutor>();
+    std::vector<int> seen;
+    Dispatcher<int> dispatch;
+    auto stats = dispatch.via(manual).bounded(4, OverflowPolicy::DropNewest).to([&seen](int i){
+        if(i == 1)
+            throw std::runtime_error("observer failed");
+        seen.push_back(i);
+    });
+    for(int i = 0; i < 3; ++i)
+        dispatch(i);
+    
+    REQUIRE_THROWS_AS(manual->runAll(), std::runtime_error);
+    manual->runAll();
+    REQUIRE(seen == std::vector<int>({0,2}));
+    REQUIRE(stats->delivered == 2u);
+    
+    dispatch(3);
+    REQUIRE(manual->tasks.size() == 1u);
+    manual->runAll();
+    REQUIRE(seen == std::vector<int>({0,2,3}));
+}
+
+
+TEST_CASE("Bounded observers with OverflowPolicy::Block hold back the producer","[dispatcher][bounded]") {
+    auto pool = std::make_shared<ThreadPoolExecutor>(1);
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::vector<int> seen;
+    
+    Dispatcher<int> dispatch;
+    auto stats = dispatch.via(pool).bounded(2, OverflowPolicy::Block).to([&seen,released](int i){
+        released.wait();
+        seen.push_back(i);
+    });
+    
+    auto producer = std::async(std::launch::async, [&dispatch]{
+        for(int i = 0; i < 10; ++i)
+            dispatch(i);
+    });
+    
+    while(stats->blocked == 0u)
+        std::this_thread::yield();
+    REQUIRE(producer.wait_for(std::chrono::milliseconds(10)) == std::future_status::timeout);
+    
+    release.set_value();
+    producer.wait();
+    while(stats->delivered < 10u)
+        std::this_thread::yield();
+    
+    std::vector<int> expected(10);
+    std::iota(expected.begin(), expected.end(), 0);
+    REQUIRE(seen == expected);
+}
+
+
+TEST_CASE("Concurrent producers publish through input() without losing events","[dispatcher][input]") {
+    auto immediate = std::make_shared<ImmediateExecutor>();
+    auto received = std::make_shared<std::atomic<long>>(0);
+    const int producers = 8, eventsPerProducer = 10000;
+    
+    auto dispatch = std::make_shared<Dispatcher<int>>();
+    dispatch->via(immediate).to([received](int i){ *received += i; });
+    auto input = dispatch->input();
+    
+    std::vector<std::thread> threads;
+    for(int p = 0; p < producers; ++p)
+        threads.emplace_back([input,eventsPerProducer]{
+            for(int i = 0; i < eventsPerProducer; ++i)
+                input(1);
+        });
+    for(auto& t : threads)
+        t.join();
+    REQUIRE(*received == producers * eventsPerProducer);
+    
+    WHEN("the dispatcher has been destroyed") {
+        dispatch = nullptr;
+        THEN("publishing through its input throws") {
+            REQUIRE_THROWS(input(1));
+        }
+    }
+}
+
+
+TEST_CASE("Image processing stages chain as Tasks","[processing][task]") {
+    using frame = std::shared_ptr<const picture>;
+    using img = std::shared_ptr<const image>;
+    
+    auto pool = frame_pool::create(frame_format{ 32u, 16u }, 1u);
+    auto raw = pool->acquire();
+    std::fill(raw.data(), raw.data() + raw.size(), uint8_t(128));
+    
+    img result;
+    Task<img(frame)> demosaic(Delegate<img(frame)>::create<&Processing::demosaicStage>());
+    Task<img(img)> gray(Delegate<img(img)>::create<&Processing::grayStage>());
+    Task<img(img)> halve(Delegate<img(img)>::create<&Processing::halveStage>());
+    Task<void(img)> sink(Delegate<void(img)>::create([&result](img i){ result = i; }));
+    demosaic >>= gray;
+    gray >>= halve;
+    halve >>= sink;
+    
+    demosaic.input()(std::make_shared<picture>(std::move(raw)));
+    REQUIRE(result);
+    REQUIRE(1u == result->channels);
+    REQUIRE(16u == result->width);
+    REQUIRE(8u == result->height);
+    REQUIRE(128u == result->pixels.front());
+}
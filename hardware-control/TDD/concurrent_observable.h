@@ -0,0 +1,253 @@
+#pragma once
+#include <TDD/iobservable.h>
+#include <TDD/ilistener.h>
+#include <TDD/rcu_cell.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/// What the threads notifying concurrent_observables are doing, so that
+/// unregistering a listener can wait for its notifications without deadlock.
+namespace concurrent_notification {
+
+    /// the slots this thread is notifying, innermost last
+    inline std::vector<const void*>& active() {
+        static thread_local std::vector<const void*> slots;
+        return slots;
+    }
+
+    /// a thread waiting for the notifications of a slot to finish
+    struct waiter {
+        const void* waiting_for;
+        std::vector<const void*> notifying;
+    };
+
+    inline std::mutex& waiters_mutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    inline std::vector<const waiter*>& waiters() {
+        static std::vector<const waiter*> all;
+        return all;
+    }
+
+    inline bool contains(const std::vector<const void*>& slots, const void* slot) {
+        return std::find(slots.begin(), slots.end(), slot) != slots.end();
+    }
+
+    /// whether w would wait, through a chain of waiting threads, for a slot it notifies itself
+    inline bool closes_cycle(const waiter& w) {
+        std::vector<const void*> reached { w.waiting_for };
+        for(size_t i = 0u; i < reached.size(); ++i)
+            for(auto other : waiters())
+                if(contains(other->notifying, reached[i])) {
+                    if(contains(w.notifying, other->waiting_for))
+                        return true;
+                    if(!contains(reached, other->waiting_for))
+                        reached.push_back(other->waiting_for);
+                }
+        return false;
+    }
+
+    /// waits while busy() holds, unless the threads keeping the slot busy wait
+    /// for this one; of a cycle of waiting threads, the last to arrive goes on
+    template <typename Busy>
+    void wait_for(const void* slot, Busy busy) {
+        if(!busy())
+            return;
+        const waiter self { slot, active() };
+        {
+            std::lock_guard<std::mutex> lock(waiters_mutex());
+            if(closes_cycle(self))
+                return;
+            waiters().push_back(&self);
+        }
+        while(busy())
+            std::this_thread::yield();
+        std::lock_guard<std::mutex> lock(waiters_mutex());
+        waiters().erase(std::find(waiters().begin(), waiters().end(), &self));
+    }
+}
+
+
+/// Thread-safe observable for values that are read by many threads and written
+/// by few. Every assignment publishes a new immutable snapshot through an
+/// rcu_cell: readers only copy a shared_ptr and never wait for writers, and a
+/// snapshot stays valid for as long as a reader holds it.
+///
+/// Snapshots are numbered in the order they are published. A listener is
+/// notified by one thread at a time and only with snapshots newer than the
+/// one it saw last: a writer that finds a listener busy leaves the newer
+/// snapshot to the thread notifying it. So a listener sees the values in
+/// assignment order, may skip values when writers race, and its last
+/// notification is always the current snapshot.
+///
+/// The listener list is copy-on-write as well, and writers notify without
+/// holding any lock, so listeners may register or unregister listeners while
+/// they are notified. Unregistering waits until the listener is not notified
+/// by any other thread. The only exception are listeners that unregister each
+/// other from notifications running on different threads: the last of them
+/// to unregister returns without waiting, since the others wait for it, and
+/// must not destroy the listener it unregistered from within that
+/// notification. Since ilistener runs its RAII cleanup after the derived
+/// listener is gone, a listener notified from other threads has to unregister
+/// itself before it is destroyed.
+template <typename T>
+class concurrent_observable : public iobservable<T> {
+    struct versioned {
+        uint64_t sequence;
+        T value;
+    };
+
+    struct slot {
+        ilistener<T>* const listener;
+        std::atomic<size_t> notifying{0u};
+        std::atomic<bool> registered{true};
+        std::atomic<bool> delivering{false};
+        std::atomic<uint64_t> delivered{0u};
+        slot(ilistener<T>* listener) : listener(listener) {}
+    };
+    using slot_list = std::vector<std::shared_ptr<slot>>;
+
+    /// counts the notifications of a slot, and records it for the calling thread
+    struct in_notification {
+        slot& s;
+        explicit in_notification(slot& s) : s(s) { concurrent_notification::active().push_back(&s); ++s.notifying; }
+        ~in_notification() { --s.notifying; concurrent_notification::active().pop_back(); }
+    };
+
+    rcu_cell<versioned> value;
+    rcu_cell<slot_list> listeners;
+    std::mutex registration;
+
+    void registerListener_impl(ilistener<T>& l) override;
+
+    void unregisterListener_impl(ilistener<T>& l) override;
+
+    void publish(std::shared_ptr<versioned> fresh);
+
+    void notify(slot& s);
+
+public:
+    explicit concurrent_observable(T value);
+
+    concurrent_observable(const concurrent_observable& other) = delete;
+
+    concurrent_observable& operator = (const concurrent_observable& other) = delete;
+
+    ~concurrent_observable();
+
+    concurrent_observable& operator=(const T& val);
+
+    concurrent_observable& operator=(T&& val);
+
+    /// the current value; lock-free and unaffected by later assignments
+    std::shared_ptr<const T> snapshot() const;
+
+    operator T () const;
+};
+
+
+/// the cleanup is added before the slot is published, since a notification
+/// on another thread may unregister the listener right away
+template <typename T>
+void concurrent_observable<T>::registerListener_impl(ilistener<T>& l) {
+    std::lock_guard<std::mutex> lock(registration);
+    auto updated = std::make_shared<slot_list>(*listeners.load());
+    auto added = std::make_shared<slot>(&l);
+    added->delivered = value.load()->sequence;
+    updated->push_back(std::move(added));
+    l.add_raii(this,[this,&l]{ this->unregisterListener(l); });
+    listeners.store(std::move(updated));
+}
+
+template <typename T>
+void concurrent_observable<T>::unregisterListener_impl(ilistener<T>& l) {
+    std::shared_ptr<slot> removed;
+    {
+        std::lock_guard<std::mutex> lock(registration);
+        auto updated = std::make_shared<slot_list>(*listeners.load());
+        auto it = std::find_if(updated->begin(), updated->end(), [&l](const std::shared_ptr<slot>& s){ return s->listener == &l; });
+        if(it == updated->end())
+            return;
+        removed = *it;
+        updated->erase(it);
+        listeners.store(std::move(updated));
+    }
+    l.remove_raii(this);
+    removed->registered = false;
+    const auto& active = concurrent_notification::active();
+    const size_t own = static_cast<size_t>(std::count(active.begin(), active.end(), removed.get()));
+    concurrent_notification::wait_for(removed.get(), [&removed,own]{ return removed->notifying != own; });
+}
+
+/// the sequence number is taken from the snapshot being replaced, so the
+/// numbers follow the order in which the snapshots were stored
+template <typename T>
+void concurrent_observable<T>::publish(std::shared_ptr<versioned> fresh) {
+    value.update([&fresh](const std::shared_ptr<const versioned>& old) {
+        fresh->sequence = old->sequence + 1u;
+        return fresh;
+    });
+    const auto current = listeners.load();
+    for(const auto& s : *current)
+        notify(*s);
+}
+
+/// a thread that finds the slot busy returns; the notifying thread checks for
+/// a newer snapshot after it lets go of the slot
+template <typename T>
+void concurrent_observable<T>::notify(slot& s) {
+    while(s.registered && value.load()->sequence > s.delivered && !s.delivering.exchange(true)) {
+        {
+            in_notification guard(s);
+            for(auto latest = value.load(); s.registered && latest->sequence > s.delivered; latest = value.load()) {
+                s.delivered = latest->sequence;
+                s.listener->handle(latest->value);
+            }
+        }
+        s.delivering = false;
+    }
+}
+
+template <typename T>
+concurrent_observable<T>::concurrent_observable(T value)
+: value(std::make_shared<const versioned>(versioned{ 0u, std::move(value) }))
+, listeners(std::make_shared<const slot_list>())
+{
+}
+
+template <typename T>
+concurrent_observable<T>::~concurrent_observable() {
+    for(const auto& s : *listeners.load())
+        s->listener->remove_raii(this);
+}
+
+template <typename T>
+concurrent_observable<T>& concurrent_observable<T>::operator=(const T& val) {
+    publish(std::make_shared<versioned>(versioned{ 0u, val }));
+    return *this;
+}
+
+template <typename T>
+concurrent_observable<T>& concurrent_observable<T>::operator=(T&& val) {
+    publish(std::make_shared<versioned>(versioned{ 0u, std::move(val) }));
+    return *this;
+}
+
+template <typename T>
+std::shared_ptr<const T> concurrent_observable<T>::snapshot() const {
+    const auto current = value.load();
+    return std::shared_ptr<const T>(current, &current->value);
+}
+
+template <typename T>
+concurrent_observable<T>::operator T () const {
+    return *snapshot();
+}
\ No newline at end of file
@@ -0,0 +1,239 @@
+#include <TDD/concurrent_observable.h>
+#include <TDD/listener.h>
+#include <catch.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+
+namespace {
+
+struct counting_listener final : ilistener<int> {
+    std::atomic<size_t> triggered{0u};
+    std::atomic<int> last{0};
+private:
+    void handle_impl(int&& i) override {
+        last = i;
+        ++triggered;
+    }
+};
+
+}
+
+
+TEST_CASE("Assigning a concurrent_observable notifies its listeners", "[concurrent_observable]") {
+    concurrent_observable<int> obs(0);
+    counting_listener lstnr1, lstnr2;
+    obs.registerListener(lstnr1);
+    obs.registerListener(lstnr2);
+    obs = 42;
+    REQUIRE(lstnr1.last == 42);
+    REQUIRE(lstnr2.last == 42);
+    REQUIRE(42 == static_cast<int>(obs));
+    
+    WHEN("a listener unregisters") {
+        obs.unregisterListener(lstnr1);
+        obs = 43;
+        THEN("it is not notified anymore") {
+            REQUIRE(lstnr1.triggered == 1u);
+            REQUIRE(lstnr2.triggered == 2u);
+        }
+    }
+}
+
+
+TEST_CASE("A snapshot of a concurrent_observable is unaffected by later assignments", "[concurrent_observable]") {
+    concurrent_observable<std::string> obs("first");
+    auto before = obs.snapshot();
+    obs = std::string("second");
+    REQUIRE(*before == "first");
+    REQUIRE(*obs.snapshot() == "second");
+}
+
+
+TEST_CASE("Listeners may register and unregister listeners while being notified", "[concurrent_observable]") {
+    concurrent_observable<int> obs(0);
+    counting_listener late;
+    size_t selfTriggered = 0u;
+    
+    listener<int> registering([&obs,&late](const int&){ obs.registerListener(late); });
+    obs.registerListener(registering);
+    
+    std::unique_ptr<listener<int>> self;
+    self.reset(new listener<int>([&obs,&self,&selfTriggered](const int&){
+        ++selfTriggered;
+        obs.unregisterListener(*self);
+    }));
+    obs.registerListener(*self);
+    
+    obs = 1;
+    REQUIRE(selfTriggered == 1u);
+    REQUIRE(late.triggered == 0u);
+    
+    obs.unregisterListener(registering);
+    obs = 2;
+    REQUIRE(selfTriggered == 1u);
+    REQUIRE(late.triggered == 1u);
+}
+
+
+TEST_CASE("Readers of a concurrent_observable see consistent values while writers assign", "[concurrent_observable]") {
+    struct sample { int a; int b; };
+    concurrent_observable<sample> obs(sample{0,0});
+    std::atomic<bool> done{false};
+    std::atomic<size_t> inconsistent{0u};
+    
+    std::vector<std::thread> readers;
+    for(int r = 0; r < 4; ++r)
+        readers.emplace_back([&]{
+            int previous = 0;
+            while(!done) {
+                const auto s = obs.snapshot();
+                if(s->a != s->b || s->a < previous)
+                    ++inconsistent;
+                previous = s->a;
+            }
+        });
+    
+    for(int i = 1; i <= 20000; ++i)
+        obs = sample{i,i};
+    done = true;
+    for(auto& t : readers)
+        t.join();
+    
+    REQUIRE(inconsistent == 0u);
+    REQUIRE(obs.snapshot()->a == 20000);
+}
+
+
+TEST_CASE("Several writers notify concurrently registered listeners", "[concurrent_observable]") {
+    concurrent_observable<int> obs(0);
+    counting_listener lstnr;
+    obs.registerListener(lstnr);
+    std::atomic<bool> busy{false};
+    std::atomic<size_t> overlapping{0u};
+    listener<int> exclusive([&busy,&overlapping](const int&){
+        if(busy.exchange(true))
+            ++overlapping;
+        std::this_thread::yield();
+        busy = false;
+    });
+    obs.registerListener(exclusive);
+    
+    std::vector<std::thread> writers;
+    for(int w = 0; w < 4; ++w)
+        writers.emplace_back([&obs,w]{
+            for(int i = 0; i < 1000; ++i)
+                obs = w * 1000 + i;
+        });
+    for(auto& t : writers)
+        t.join();
+    
+    REQUIRE(lstnr.triggered >= 1u);
+    REQUIRE(lstnr.triggered <= 4000u);
+    REQUIRE(lstnr.last == *obs.snapshot());
+    REQUIRE(overlapping == 0u);
+}
+
+
+TEST_CASE("Unregistering a listener from a concurrent_observable drops its cleanup functor", "[concurrent_observable]") {
+    counting_listener lstnr;
+    std::unique_ptr<concurrent_observable<int>> obs(new concurrent_observable<int>(0));
+    obs->registerListener(lstnr);
+    REQUIRE(lstnr.has_raii(obs.get()));
+    obs->unregisterListener(lstnr);
+    REQUIRE_FALSE(lstnr.has_raii(obs.get()));
+    obs.reset();
+}
+
+
+TEST_CASE("Listeners notified on different threads may unregister each other", "[concurrent_observable]") {
+    concurrent_observable<int> obs(0);
+    std::atomic<bool> first{true}, in1{false}, in2{false};
+    std::unique_ptr<listener<int>> l1, l2;
+    
+    l1.reset(new listener<int>([&](const int&){
+        if(!first.exchange(false))
+            return;
+        in1 = true;
+        while(!in2)
+            std::this_thread::yield();
+        obs.unregisterListener(*l2);
+    }));
+    l2.reset(new listener<int>([&](const int&){
+        if(in2.exchange(true))
+            return;
+        while(!in1)
+            std::this_thread::yield();
+        obs.unregisterListener(*l1);
+    }));
+    obs.registerListener(*l1);
+    obs.registerListener(*l2);
+    
+    std::thread a([&obs]{ obs = 1; });
+    while(!in1)
+        std::this_thread::yield();
+    std::thread b([&obs]{ obs = 2; });
+    a.join();
+    b.join();
+    
+    REQUIRE_FALSE(l1->has_raii(&obs));
+    REQUIRE_FALSE(l2->has_raii(&obs));
+}
+
+
+TEST_CASE("Unregistering from a notification of another observable waits for the listener", "[concurrent_observable]") {
+    concurrent_observable<int> x(0), y(0);
+    std::atomic<bool> inY{false}, finishedY{false};
+    bool finishedWhenUnregistered = false;
+    
+    listener<int> ly([&](const int&){
+        inY = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        finishedY = true;
+    });
+    listener<int> lx([&](const int&){
+        while(!inY)
+            std::this_thread::yield();
+        y.unregisterListener(ly);
+        finishedWhenUnregistered = finishedY;
+    });
+    y.registerListener(ly);
+    x.registerListener(lx);
+    
+    std::thread notifyingY([&y]{ y = 1; });
+    x = 1;
+    notifyingY.join();
+    
+    REQUIRE(finishedWhenUnregistered);
+}
+
+
+TEST_CASE("An rcu_cell hands out the stored pointer while writers replace it", "[concurrent_observable]") {
+    rcu_cell<std::string> cell(std::make_shared<const std::string>("0"));
+    std::atomic<bool> done{false};
+    std::atomic<size_t> empty{0u};
+    
+    std::vector<std::thread> readers;
+    for(int r = 0; r < 4; ++r)
+        readers.emplace_back([&]{
+            while(!done)
+                if(cell.load()->empty())
+                    ++empty;
+        });
+    std::vector<std::thread> writers;
+    for(int w = 0; w < 2; ++w)
+        writers.emplace_back([&cell]{
+            for(int i = 1; i <= 2000; ++i)
+                cell.store(std::make_shared<const std::string>(std::to_string(i)));
+        });
+    for(auto& t : writers)
+        t.join();
+    done = true;
+    for(auto& t : readers)
+        t.join();
+    
+    REQUIRE(empty == 0u);
+    REQUIRE(*cell.load() == "2000");
+}
@@ -0,0 +1,157 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+/// Parameter trees: a container<...> holds one value per SYMBOLIC attribute
+/// and one sub-container per SYMBOLIC_F field, accessed by the attribute or
+/// field object, e.g. params[SensorField][ApdHv]. index() is a 16 bit hash
+/// of the element's name, so the same declaration gets the same tag in every
+/// translation unit and every build, host or firmware. Renaming an element
+/// changes its tag. See container_binary.h for the binary encoding.
+
+template <typename Element> struct
+field {};
+
+
+/// FNV-1a of the name, folded to 16 bits
+constexpr uint32_t container_name_hash(const char* name, uint32_t h = 2166136261u) {
+    return *name ? container_name_hash(name + 1, (h ^ static_cast<uint8_t>(*name)) * 16777619u) : h;
+}
+
+constexpr int container_tag(const char* name) {
+    return static_cast<int>((container_name_hash(name) >> 16) ^ (container_name_hash(name) & 0xFFFFu));
+}
+
+
+
+template <typename E, typename...Es> struct
+container : container<E>, container<Es...> {
+    using container<E>::operator[];
+    using container<Es...>::operator[];
+    
+    void writeTo (std::ostream& ostr, size_t indent=0u) const {
+        static_cast<container<E> const*>(this)->writeTo(ostr,indent);
+        static_cast<container<Es...> const*>(this)->writeTo(ostr,indent);
+    }
+    
+    friend std::ostream& operator<< (std::ostream& ostr, const container& c) {
+        c.writeTo(ostr);
+        return ostr;
+    }
+};
+
+template <typename T> struct DataOutFormat {
+    static void writeTo(std::ostream& ostr, const T& val) {
+        ostr << val;
+    }
+};
+
+template <> struct
+DataOutFormat<std::string> {
+    static void writeTo(std::ostream& ostr, const std::string& str) {
+        ostr << "\"" << str << "\"";
+    }
+};
+
+template <typename Element> struct
+container<field<Element>>  {
+    auto&
+    operator[](field<Element>) {
+        return value;
+    }
+    
+    const auto&
+    operator[](field<Element>) const {
+        return value;
+    }
+    
+    void writeTo (std::ostream& ostr, size_t indent=0u) const {
+        std::string s(indent,' ');
+        ostr << s << "SubContainer {\"" << Element{} << "\" \"" << Element{} << "\" {\n"
+             << s << "AttrContainer {\n";
+        value.writeTo(ostr,indent+4u);
+        ostr << s << "}\n";
+    }
+private:
+    typename Element::value_type value;
+};
+
+
+
+
+template <typename Element> struct
+container<Element> {
+    template <typename ElementIn>
+    std::enable_if_t<
+        std::is_same<ElementIn,Element>::value && Element{}.index() == ElementIn{}.index(),
+        typename Element::value_type&>
+    operator[](ElementIn) {
+        return value;
+    }
+    
+    template <typename ElementIn>
+    std::enable_if_t<
+        std::is_same<ElementIn,Element>::value && Element{}.index() == ElementIn{}.index(),
+        const typename Element::value_type&>
+    operator[](ElementIn) const {
+        return value;
+    }
+    
+    void writeTo (std::ostream& ostr, size_t indent=0u) const {
+//        std::cout << "AAAAAAAAA" << printtype<attr>() << std::endl;
+        std::string s(indent,' ');
+        ostr << s << "Attr<" << Element{}.type_name() << "> { \n"
+             << s << "\tName \"" << Element{} << "\"\n"
+             << s << "\tValue ";
+        DataOutFormat<decltype(value)>::writeTo(ostr,value);
+        ostr << s << "\n"
+             << s << "}\n";
+    }
+
+    typename Element::value_type value;
+};
+
+
+#define DEFER_(...) __VA_ARGS__
+#define DEFER(...) DEFER_(__VA_ARGS__)
+#define CONCATENATE(X,Y,Z)  X ## Y ## Z
+#define STRUCT(NAME)  CONCATENATE( S_,NAME, )
+#define FIELD(NAME)   CONCATENATE( F_,NAME, )
+#define TYPE(NAME)    CONCATENATE( T_,NAME, )
+
+#define SYMBOLIC(NAME,TYPE) \
+    static constexpr struct STRUCT(NAME) { \
+        constexpr operator const char*() const { return #NAME; } \
+        constexpr const char* type_name() const { return #TYPE; } \
+        constexpr int index() const { return container_tag(#NAME); } \
+        using value_type = TYPE; \
+    } NAME {};
+
+
+#define SYMBOLIC_F(NAME,T) \
+    struct STRUCT(T) { \
+        constexpr operator const char*() const { return #NAME; } \
+        constexpr const char* type_name() const { return #T; } \
+        constexpr int index() const { return container_tag(#NAME); } \
+        using value_type = T; \
+    }; \
+    constexpr field<STRUCT(T)> NAME {};
+
+#define CONTAINER_BEGIN(NAME) \
+    using TYPE(NAME) = container<
+#define ATTR_DECL(ATTR) \
+    std::decay_t<decltype(FIELD(ATTR))>
+#define CONTAINER_END() \
+    >;
+
+#define CONTAINER_DECL_BEGIN(NAME) \
+    namespace FIELD(NAME) {
+#define CONTAINER_DECL_END() \
+    }
+
+
+
+#define ATTR(NAME,TYPE) NAME, TYPE
+#define APPLY_TO(F, ...) F(__VA_ARGS__)
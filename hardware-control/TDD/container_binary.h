@@ -0,0 +1,354 @@
+#pragma once
+#include <TDD/container.h>
+#include <TDD/span.h>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/// Binary encoding of container<...> parameter trees.
+///
+/// Every element is written in declaration order as
+///     tag   u16  Element{}.index()
+///     size  u32  payload length in bytes
+///     payload    arithmetic values as little endian bytes, strings as raw
+///                bytes, sub-containers as their own sequence of elements
+/// The layout is fixed by the container type, so encoding and decoding are
+/// plain template recursion. Tags are hashes of the element names (see
+/// container.h), so a blob written by one build, e.g. on the host, is read
+/// by any other build with the same declarations, e.g. device firmware. The
+/// elements of one container must have distinct tags; this is checked at
+/// compile time.
+
+struct decode_error : std::runtime_error {
+    decode_error(const std::string& what, size_t offset)
+        : std::runtime_error(what + " at byte " + std::to_string(offset)), offset(offset)
+    {}
+
+    size_t offset;
+};
+
+namespace container_binary {
+    constexpr size_t header_size = sizeof(uint16_t) + sizeof(uint32_t);
+
+    template <typename T>
+    using uint_of = std::conditional_t<sizeof(T) == 1, uint8_t,
+                    std::conditional_t<sizeof(T) == 2, uint16_t,
+                    std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>>;
+
+    template <typename T>
+    void store_le(uint8_t* out, T value) {
+        uint_of<T> bits;
+        std::memcpy(&bits, &value, sizeof(T));
+        for(size_t i = 0u; i < sizeof(T); ++i)
+            out[i] = static_cast<uint8_t>(bits >> (8u * i));
+    }
+
+    template <typename T>
+    T load_le(const uint8_t* in) {
+        uint_of<T> bits = 0u;
+        for(size_t i = 0u; i < sizeof(T); ++i)
+            bits |= static_cast<uint_of<T>>(in[i]) << (8u * i);
+        T value;
+        std::memcpy(&value, &bits, sizeof(T));
+        return value;
+    }
+
+    struct header {
+        uint16_t tag;
+        uint32_t size;
+    };
+
+    /// reads the element header at offset and checks that its payload fits in bytes
+    inline header read_header(span<const uint8_t> bytes, size_t offset) {
+        if(bytes.size() - offset < header_size)
+            throw decode_error("truncated element header", offset);
+        header h { load_le<uint16_t>(bytes.data() + offset),
+                   load_le<uint32_t>(bytes.data() + offset + sizeof(uint16_t)) };
+        if(bytes.size() - offset - header_size < h.size)
+            throw decode_error("element payload exceeds buffer", offset);
+        return h;
+    }
+
+    /// read() gets bytes cut off at the end of the payload and the offset where it starts
+    template <typename T, typename = void> struct
+    payload;
+
+    template <typename T> struct
+    payload<T, std::enable_if_t<std::is_arithmetic<T>::value>> {
+        static_assert(sizeof(T) <= sizeof(uint64_t), "arithmetic fields are stored through an integer of up to 64 bits; long double is not supported");
+
+        static size_t size(const T&) { return sizeof(T); }
+
+        static void write(uint8_t* out, const T& value) { store_le(out, value); }
+
+        static void read(span<const uint8_t> bytes, size_t offset, T& value) {
+            if(bytes.size() - offset != sizeof(T))
+                throw decode_error("arithmetic payload has the wrong size", offset);
+            value = load_le<T>(bytes.data() + offset);
+        }
+    };
+
+    template <> struct
+    payload<std::string> {
+        static size_t size(const std::string& str) { return str.size(); }
+
+        static void write(uint8_t* out, const std::string& str) {
+            std::memcpy(out, str.data(), str.size());
+        }
+
+        static void read(span<const uint8_t> bytes, size_t offset, std::string& str) {
+            str.assign(reinterpret_cast<const char*>(bytes.data() + offset), bytes.size() - offset);
+        }
+    };
+
+    /// walks the elements of a container; specialized for each container shape
+    template <typename Container> struct
+    codec;
+
+    /// a sub-container is the payload of its field and has to fill it exactly
+    template <typename... Es> struct
+    payload<container<Es...>> {
+        using elements = codec<container<Es...>>;
+
+        static size_t size(const container<Es...>& c) { return elements::size(c); }
+
+        static void write(uint8_t* out, const container<Es...>& c) { elements::write(out, c); }
+
+        static void read(span<const uint8_t> bytes, size_t offset, container<Es...>& c) {
+            const size_t end = elements::read(bytes, offset, c);
+            if(end != bytes.size())
+                throw decode_error("trailing bytes after container", end);
+        }
+    };
+
+    template <typename Element, typename Value> struct
+    element_codec {
+        static_assert(Element{}.index() >= 0 && Element{}.index() <= 0xFFFF, "tag does not fit into u16");
+        static constexpr uint16_t tag = static_cast<uint16_t>(Element{}.index());
+
+        static size_t size(const Value& value) {
+            return header_size + payload<Value>::size(value);
+        }
+
+        static uint8_t* write(uint8_t* out, const Value& value) {
+            const size_t n = payload<Value>::size(value);
+            store_le(out, tag);
+            store_le(out + sizeof(uint16_t), static_cast<uint32_t>(n));
+            payload<Value>::write(out + header_size, value);
+            return out + header_size + n;
+        }
+
+        static size_t read(span<const uint8_t> bytes, size_t offset, Value& value) {
+            const header h = read_header(bytes, offset);
+            if(h.tag != tag)
+                throw decode_error("unexpected tag " + std::to_string(h.tag) + ", expected " + std::to_string(tag), offset);
+            const size_t end = offset + header_size + h.size;
+            payload<Value>::read(bytes.first(end), offset + header_size, value);
+            return end;
+        }
+    };
+
+    template <typename Element> struct
+    codec<container<Element>> {
+        using element = element_codec<Element, typename Element::value_type>;
+
+        static size_t size(const container<Element>& c) { return element::size(c[Element{}]); }
+
+        static uint8_t* write(uint8_t* out, const container<Element>& c) {
+            return element::write(out, c[Element{}]);
+        }
+
+        static size_t read(span<const uint8_t> bytes, size_t offset, container<Element>& c) {
+            return element::read(bytes, offset, c[Element{}]);
+        }
+    };
+
+    template <typename Element> struct
+    codec<container<field<Element>>> {
+        using element = element_codec<Element, typename Element::value_type>;
+
+        static size_t size(const container<field<Element>>& c) { return element::size(c[field<Element>{}]); }
+
+        static uint8_t* write(uint8_t* out, const container<field<Element>>& c) {
+            return element::write(out, c[field<Element>{}]);
+        }
+
+        static size_t read(span<const uint8_t> bytes, size_t offset, container<field<Element>>& c) {
+            return element::read(bytes, offset, c[field<Element>{}]);
+        }
+    };
+
+    template <typename Element> struct
+    element_tag {
+        static constexpr uint16_t value = static_cast<uint16_t>(Element{}.index());
+    };
+
+    template <typename Element> struct
+    element_tag<field<Element>> : element_tag<Element> {};
+
+    constexpr bool unique_tag(uint16_t tag, std::initializer_list<uint16_t> others) {
+        for(uint16_t other : others)
+            if(other == tag)
+                return false;
+        return true;
+    }
+
+    template <typename E, typename... Es> struct
+    codec<container<E, Es...>> {
+        static_assert(unique_tag(element_tag<E>::value, { element_tag<Es>::value... }),
+                      "two elements of a container hash to the same tag; rename one of them");
+
+        using head = codec<container<E>>;
+        using tail = codec<container<Es...>>;
+
+        static size_t size(const container<E, Es...>& c) {
+            return head::size(c) + tail::size(c);
+        }
+
+        static uint8_t* write(uint8_t* out, const container<E, Es...>& c) {
+            return tail::write(head::write(out, c), c);
+        }
+
+        static size_t read(span<const uint8_t> bytes, size_t offset, container<E, Es...>& c) {
+            return tail::read(bytes, head::read(bytes, offset, c), c);
+        }
+    };
+}
+
+
+/// encodes into out, reusing its capacity
+template <typename... Es>
+void encode(const container<Es...>& c, std::vector<uint8_t>& out) {
+    using codec = container_binary::codec<container<Es...>>;
+    out.resize(codec::size(c));
+    codec::write(out.data(), c);
+}
+
+template <typename... Es>
+std::vector<uint8_t> encode(const container<Es...>& c) {
+    std::vector<uint8_t> out;
+    encode(c, out);
+    return out;
+}
+
+/// throws decode_error if bytes do not hold exactly the layout of c
+template <typename... Es>
+void decode(span<const uint8_t> bytes, container<Es...>& c) {
+    container_binary::payload<container<Es...>>::read(bytes, 0u, c);
+}
+
+template <typename Container>
+Container decode(span<const uint8_t> bytes) {
+    Container c;
+    decode(bytes, c);
+    return c;
+}
+
+
+
+/// Reads single elements straight out of an encoded blob, e.g. a mapped
+/// parameter file, without decoding the rest. Arithmetic values are copied
+/// out, strings are returned as span<const char> and sub-containers as
+/// nested views into the same bytes. The blob has to outlive the view.
+template <typename Container> class
+container_view;
+
+namespace container_binary {
+    template <typename T, typename = void> struct
+    view_of {
+        using type = T;
+        static type get(span<const uint8_t> bytes, size_t offset) {
+            T value;
+            payload<T>::read(bytes, offset, value);
+            return value;
+        }
+    };
+
+    template <> struct
+    view_of<std::string> {
+        using type = span<const char>;
+        static type get(span<const uint8_t> bytes, size_t offset) {
+            return { reinterpret_cast<const char*>(bytes.data() + offset), bytes.size() - offset };
+        }
+    };
+
+    template <typename... Es> struct
+    view_of<container<Es...>> {
+        using type = container_view<container<Es...>>;
+        static type get(span<const uint8_t> bytes, size_t offset) {
+            return type(bytes.subspan(offset));
+        }
+    };
+
+    template <typename Container, typename Element> struct
+    has_element : std::integral_constant<bool,
+        std::is_same<container<Element>, Container>::value ||
+        std::is_base_of<container<Element>, Container>::value> {};
+
+    template <typename Element> struct
+    element_of {
+        using type = Element;
+    };
+
+    template <typename Element> struct
+    element_of<field<Element>> {
+        using type = Element;
+    };
+}
+
+template <typename Container> class
+container_view {
+    span<const uint8_t> bytes;
+
+public:
+    /// checks that the element headers tile bytes; payloads are checked on access
+    explicit container_view(span<const uint8_t> bytes);
+
+    template <typename ElementIn>
+    typename container_binary::view_of<typename container_binary::element_of<ElementIn>::type::value_type>::type
+    operator[](ElementIn) const;
+
+private:
+    size_t find(uint16_t tag) const;
+};
+
+
+
+template <typename Container>
+container_view<Container>::container_view(span<const uint8_t> bytes)
+: bytes(bytes)
+{
+    size_t offset = 0u;
+    while(offset != bytes.size())
+        offset += container_binary::header_size + container_binary::read_header(bytes, offset).size;
+}
+
+template <typename Container>
+template <typename ElementIn>
+typename container_binary::view_of<typename container_binary::element_of<ElementIn>::type::value_type>::type
+container_view<Container>::operator[](ElementIn) const {
+    using namespace container_binary;
+    static_assert(has_element<Container, ElementIn>::value, "element is not part of this container");
+    using element = typename element_of<ElementIn>::type;
+    using value_type = typename element::value_type;
+    const size_t offset = find(element_codec<element, value_type>::tag);
+    const size_t end = offset + header_size + read_header(bytes, offset).size;
+    return view_of<value_type>::get(bytes.first(end), offset + header_size);
+}
+
+/// elements are laid out in declaration order, so this is a short walk over the headers
+template <typename Container>
+size_t container_view<Container>::find(uint16_t tag) const {
+    size_t offset = 0u;
+    while(offset != bytes.size()) {
+        const auto h = container_binary::read_header(bytes, offset);
+        if(h.tag == tag)
+            return offset;
+        offset += container_binary::header_size + h.size;
+    }
+    throw decode_error("no element with tag " + std::to_string(tag), offset);
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <TDD/container_binary.h>
+#include <cstdint>
+#include <vector>
+
+/// Patches between two parameter trees of the same container type.
+///
+/// A patch uses the element encoding of container_binary.h but holds only
+/// the attributes whose values differ, in declaration order. A field is
+/// written only if something below it changed, and its payload is the patch
+/// of its sub-container. Unchanged trees give an empty patch. The tags are
+/// the name hashes of container.h, so a patch made on the host applies to
+/// the same declarations in separately built firmware.
+
+namespace container_patch {
+    using container_binary::header_size;
+
+    template <typename Container> struct
+    codec;
+
+    template <typename Element> struct
+    codec<container<Element>> {
+        using value_type = typename Element::value_type;
+        using element = container_binary::element_codec<Element, value_type>;
+
+        static void diff(const container<Element>& from, const container<Element>& to, std::vector<uint8_t>& out) {
+            const value_type& value = to[Element{}];
+            if(from[Element{}] == value)
+                return;
+            const size_t offset = out.size();
+            out.resize(offset + element::size(value));
+            element::write(out.data() + offset, value);
+        }
+
+        static size_t apply(span<const uint8_t> patch, size_t offset, container<Element>& c) {
+            if(offset == patch.size() || container_binary::read_header(patch, offset).tag != element::tag)
+                return offset;
+            return element::read(patch, offset, c[Element{}]);
+        }
+    };
+
+    template <typename Element> struct
+    codec<container<field<Element>>> {
+        using sub = codec<typename Element::value_type>;
+        static constexpr uint16_t tag = container_binary::element_codec<Element, typename Element::value_type>::tag;
+
+        /// the header is written up front and dropped again if the sub-container is unchanged
+        static void diff(const container<field<Element>>& from, const container<field<Element>>& to, std::vector<uint8_t>& out) {
+            const size_t offset = out.size();
+            out.resize(offset + header_size);
+            sub::diff(from[field<Element>{}], to[field<Element>{}], out);
+            const size_t n = out.size() - offset - header_size;
+            if(n == 0u) {
+                out.resize(offset);
+                return;
+            }
+            container_binary::store_le(out.data() + offset, tag);
+            container_binary::store_le(out.data() + offset + sizeof(uint16_t), static_cast<uint32_t>(n));
+        }
+
+        static size_t apply(span<const uint8_t> patch, size_t offset, container<field<Element>>& c) {
+            if(offset == patch.size())
+                return offset;
+            const auto h = container_binary::read_header(patch, offset);
+            if(h.tag != tag)
+                return offset;
+            const size_t end = offset + header_size + h.size;
+            if(sub::apply(patch.first(end), offset + header_size, c[field<Element>{}]) != end)
+                throw decode_error("unexpected element in patch", offset + header_size);
+            return end;
+        }
+    };
+
+    template <typename E, typename... Es> struct
+    codec<container<E, Es...>> {
+        using head = codec<container<E>>;
+        using tail = codec<container<Es...>>;
+
+        static void diff(const container<E, Es...>& from, const container<E, Es...>& to, std::vector<uint8_t>& out) {
+            head::diff(from, to, out);
+            tail::diff(from, to, out);
+        }
+
+        static size_t apply(span<const uint8_t> patch, size_t offset, container<E, Es...>& c) {
+            return tail::apply(patch, head::apply(patch, offset, c), c);
+        }
+    };
+}
+
+
+
+/// writes the patch that turns from into to into out, reusing its capacity
+template <typename... Es>
+void diff(const container<Es...>& from, const container<Es...>& to, std::vector<uint8_t>& out) {
+    out.clear();
+    container_patch::codec<container<Es...>>::diff(from, to, out);
+}
+
+template <typename... Es>
+std::vector<uint8_t> diff(const container<Es...>& from, const container<Es...>& to) {
+    std::vector<uint8_t> out;
+    diff(from, to, out);
+    return out;
+}
+
+/// applies a patch made by diff; throws decode_error on elements that are
+/// unknown, out of order or malformed. Elements before the error are applied.
+template <typename... Es>
+void apply(span<const uint8_t> patch, container<Es...>& c) {
+    const size_t end = container_patch::codec<container<Es...>>::apply(patch, 0u, c);
+    if(end != patch.size())
+        throw decode_error("unexpected element in patch", end);
+}
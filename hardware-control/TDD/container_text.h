@@ -0,0 +1,361 @@
+#pragma once
+#include <TDD/container.h>
+#include <TDD/span.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+/// Reader for the text written by container::writeTo:
+///
+///     SubContainer {"SensorField" "SensorField" {
+///     AttrContainer {
+///         Attr<double> {
+///             Name "ApdHv"
+///             Value 57.3
+///         }
+///     }
+///
+/// Only AttrContainer and Attr close their braces, so the structure comes
+/// from the container type rather than from brace matching. Names are
+/// looked up through a perfect hash built at compile time for each
+/// container, elements may come in any order and missing ones keep their
+/// value. Tokens are spans into the text; nothing is allocated per token.
+
+struct parse_error : std::runtime_error {
+    parse_error(const std::string& what, size_t line, size_t column)
+        : std::runtime_error(std::to_string(line) + ":" + std::to_string(column) + ": " + what),
+          line(line), column(column)
+    {}
+
+    size_t line;
+    size_t column;
+};
+
+namespace container_text {
+    constexpr size_t length(const char* str) {
+        size_t n = 0u;
+        while(str[n] != '\0')
+            ++n;
+        return n;
+    }
+
+    constexpr uint32_t hash(const char* str, size_t n, uint32_t seed) {
+        uint32_t h = 2166136261u ^ seed;
+        for(size_t i = 0u; i < n; ++i) {
+            h ^= static_cast<unsigned char>(str[i]);
+            h *= 16777619u;
+        }
+        return h ^ (h >> 16);
+    }
+
+    constexpr size_t table_size(size_t n) {
+        size_t size = 1u;
+        while(size < 2u*n)
+            size *= 2u;
+        return size;
+    }
+
+    /// maps each of N names to its own slot; slot holds the name's index + 1, 0 when empty
+    template <size_t N> struct
+    perfect_hash {
+        static constexpr size_t size = table_size(N);
+
+        uint32_t seed = 0u;
+        bool found = false;
+        unsigned char slot[size] = {};
+
+        constexpr size_t operator()(const char* str, size_t n) const {
+            return hash(str, n, seed) & (size - 1u);
+        }
+    };
+
+    /// tries seeds until no two names share a slot
+    template <size_t N>
+    constexpr perfect_hash<N> make_perfect_hash(const char* const (&names)[N]) {
+        static_assert(N < std::numeric_limits<unsigned char>::max(), "too many elements in one container");
+        perfect_hash<N> h;
+        for(uint32_t seed = 0u; seed < 4096u; ++seed) {
+            h.seed = seed;
+            for(size_t s = 0u; s < perfect_hash<N>::size; ++s)
+                h.slot[s] = 0u;
+            bool collision = false;
+            for(size_t i = 0u; i < N && !collision; ++i) {
+                const size_t s = h(names[i], length(names[i]));
+                collision = h.slot[s] != 0u;
+                h.slot[s] = static_cast<unsigned char>(i + 1u);
+            }
+            if(!collision) {
+                h.found = true;
+                return h;
+            }
+        }
+        return h;
+    }
+
+    inline bool is_space(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    inline bool equals(span<const char> text, const char* str) {
+        const size_t n = std::strlen(str);
+        return text.size() == n && std::memcmp(text.data(), str, n) == 0;
+    }
+
+    class
+    lexer {
+    public:
+        enum kind { word, string, open, close, end };
+
+        struct token {
+            kind type;
+            span<const char> text;
+            size_t offset;
+        };
+
+        explicit lexer(span<const char> text);
+
+        token next();
+
+        token expect(kind type, const char* what);
+
+        void expect_word(const char* str);
+
+        /// throws parse_error with the line and column of offset
+        [[noreturn]] void fail(const std::string& what, size_t offset) const;
+
+    private:
+        span<const char> text;
+        size_t pos = 0u;
+    };
+
+    inline lexer::lexer(span<const char> text)
+    : text(text)
+    {
+    }
+
+    inline lexer::token lexer::next() {
+        while(pos != text.size() && is_space(text[pos]))
+            ++pos;
+        const size_t start = pos;
+        if(pos == text.size())
+            return { end, text.subspan(pos, 0u), start };
+        switch(text[pos]) {
+            case '{':
+                return { open, text.subspan(pos++, 1u), start };
+            case '}':
+                return { close, text.subspan(pos++, 1u), start };
+            case '"': {
+                const void* quote = std::memchr(text.data() + pos + 1u, '"', text.size() - pos - 1u);
+                if(quote == nullptr)
+                    fail("unterminated string", start);
+                pos = static_cast<const char*>(quote) - text.data() + 1u;
+                return { string, text.subspan(start + 1u, pos - start - 2u), start };
+            }
+            default:
+                while(pos != text.size() && !is_space(text[pos]) && text[pos] != '{' && text[pos] != '}' && text[pos] != '"')
+                    ++pos;
+                return { word, text.subspan(start, pos - start), start };
+        }
+    }
+
+    inline lexer::token lexer::expect(kind type, const char* what) {
+        const token t = next();
+        if(t.type != type)
+            fail(std::string("expected ") + what, t.offset);
+        return t;
+    }
+
+    inline void lexer::expect_word(const char* str) {
+        const token t = next();
+        if(t.type != word || !equals(t.text, str))
+            fail(std::string("expected ") + str, t.offset);
+    }
+
+    inline void lexer::fail(const std::string& what, size_t offset) const {
+        size_t line = 1u, column = 1u;
+        for(size_t i = 0u; i < offset; ++i) {
+            if(text[i] == '\n') {
+                ++line;
+                column = 1u;
+            } else {
+                ++column;
+            }
+        }
+        throw parse_error(what, line, column);
+    }
+
+    template <typename T, typename = void> struct
+    value;
+
+    template <typename T> struct
+    value<T, std::enable_if_t<std::is_arithmetic<T>::value>> {
+        static void read(lexer& lx, T& out) {
+            const auto t = lx.expect(lexer::word, "a number");
+            char digits[64];
+            if(t.text.size() >= sizeof(digits))
+                lx.fail("number too long", t.offset);
+            std::memcpy(digits, t.text.data(), t.text.size());
+            digits[t.text.size()] = '\0';
+            char* last = nullptr;
+            errno = 0;
+            if(!convert(digits, &last, out) || last != digits + t.text.size() || errno != 0)
+                lx.fail("invalid value " + std::string(digits), t.offset);
+        }
+
+    private:
+        template <typename U = T>
+        static std::enable_if_t<std::is_floating_point<U>::value, bool>
+        convert(const char* digits, char** last, U& out) {
+            out = static_cast<U>(std::strtod(digits, last));
+            return true;
+        }
+
+        template <typename U = T>
+        static std::enable_if_t<std::is_integral<U>::value && std::is_signed<U>::value, bool>
+        convert(const char* digits, char** last, U& out) {
+            const long long v = std::strtoll(digits, last, 10);
+            out = static_cast<U>(v);
+            return v >= std::numeric_limits<U>::min() && v <= std::numeric_limits<U>::max();
+        }
+
+        template <typename U = T>
+        static std::enable_if_t<std::is_integral<U>::value && !std::is_signed<U>::value, bool>
+        convert(const char* digits, char** last, U& out) {
+            const unsigned long long v = std::strtoull(digits, last, 10);
+            out = static_cast<U>(v);
+            return digits[0] != '-' && v <= std::numeric_limits<U>::max();
+        }
+    };
+
+    template <> struct
+    value<std::string> {
+        static void read(lexer& lx, std::string& out) {
+            const auto t = lx.expect(lexer::string, "a quoted string");
+            out.assign(t.text.data(), t.text.size());
+        }
+    };
+
+    template <typename Element> struct
+    element_of {
+        using type = Element;
+    };
+
+    template <typename Element> struct
+    element_of<field<Element>> {
+        using type = Element;
+    };
+
+    /// name dispatch over the elements of one container
+    template <typename Container> struct
+    level;
+
+    template <typename... Es> struct
+    level<container<Es...>> {
+        using handler = void(*)(lexer&, container<Es...>&, lexer::token keyword);
+
+        static constexpr const char* names[sizeof...(Es)] = { typename element_of<Es>::type{}... };
+        static constexpr perfect_hash<sizeof...(Es)> lookup = make_perfect_hash(names);
+        static_assert(lookup.found, "no perfect hash for these element names, are two of them equal?");
+        static const handler handlers[sizeof...(Es)];
+
+        /// parses elements into c until a token of kind stop
+        static void parse(lexer& lx, container<Es...>& c, lexer::kind stop);
+    };
+
+    template <typename Container, typename Element> struct
+    element {
+        static void parse(lexer& lx, Container& c, lexer::token keyword) {
+            const char* type = Element{}.type_name();
+            const size_t n = length(type);
+            const auto& text = keyword.text;
+            if(text.size() != n + 6u || std::memcmp(text.data(), "Attr<", 5u) != 0
+               || std::memcmp(text.data() + 5u, type, n) != 0 || text[n + 5u] != '>')
+                lx.fail(std::string(Element{}) + " is an Attr<" + type + ">", keyword.offset);
+            lx.expect_word("Value");
+            value<typename Element::value_type>::read(lx, c[Element{}]);
+            lx.expect(lexer::close, "'}'");
+        }
+    };
+
+    template <typename Container, typename Element> struct
+    element<Container, field<Element>> {
+        static void parse(lexer& lx, Container& c, lexer::token keyword) {
+            if(!equals(keyword.text, "SubContainer"))
+                lx.fail(std::string(Element{}) + " is a SubContainer", keyword.offset);
+            lx.expect(lexer::string, "the repeated name");
+            lx.expect(lexer::open, "'{'");
+            lx.expect_word("AttrContainer");
+            lx.expect(lexer::open, "'{'");
+            level<typename Element::value_type>::parse(lx, c[field<Element>{}], lexer::close);
+        }
+    };
+
+    template <typename... Es>
+    constexpr const char* level<container<Es...>>::names[sizeof...(Es)];
+
+    template <typename... Es>
+    constexpr perfect_hash<sizeof...(Es)> level<container<Es...>>::lookup;
+
+    template <typename... Es>
+    const typename level<container<Es...>>::handler level<container<Es...>>::handlers[sizeof...(Es)] = {
+        &element<container<Es...>, Es>::parse...
+    };
+
+    template <typename... Es>
+    void level<container<Es...>>::parse(lexer& lx, container<Es...>& c, lexer::kind stop) {
+        for(auto keyword = lx.next(); keyword.type != stop; keyword = lx.next()) {
+            const bool sub = keyword.type == lexer::word && equals(keyword.text, "SubContainer");
+            if(!sub && (keyword.type != lexer::word || keyword.text.size() < 5u || std::memcmp(keyword.text.data(), "Attr<", 5u) != 0))
+                lx.fail("expected SubContainer or Attr<...>", keyword.offset);
+            lx.expect(lexer::open, "'{'");
+            if(!sub)
+                lx.expect_word("Name");
+            const auto name = lx.expect(lexer::string, "a quoted name");
+            const size_t index = lookup.slot[lookup(name.text.data(), name.text.size())];
+            if(index == 0u || !equals(name.text, names[index - 1u]))
+                lx.fail("unknown name \"" + std::string(name.text.begin(), name.text.end()) + "\"", name.offset);
+            handlers[index - 1u](lx, c, keyword);
+        }
+    }
+}
+
+
+
+/// parses text into c; throws parse_error
+template <typename... Es>
+void parse(span<const char> text, container<Es...>& c) {
+    container_text::lexer lx(text);
+    container_text::level<container<Es...>>::parse(lx, c, container_text::lexer::end);
+}
+
+/// Reads parameter sets from streams into one buffer that is kept between
+/// calls, so loading many sets only allocates while the largest one grows.
+class
+container_reader {
+    std::string scratch;
+
+public:
+    template <typename... Es>
+    void read(std::istream& in, container<Es...>& c);
+};
+
+template <typename... Es>
+void container_reader::read(std::istream& in, container<Es...>& c) {
+    size_t size = 0u;
+    for(;;) {
+        if(scratch.size() - size < 4096u)
+            scratch.resize(std::max<size_t>(2u*scratch.size(), size + 4096u));
+        const auto n = in.rdbuf()->sgetn(&scratch[size], static_cast<std::streamsize>(scratch.size() - size));
+        if(n <= 0)
+            break;
+        size += static_cast<size_t>(n);
+    }
+    parse(span<const char>(scratch.data(), size), c);
+}
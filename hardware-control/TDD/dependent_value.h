@@ -0,0 +1,458 @@
+#pragma once
+#include <TDD/iobservable.h>
+#include <TDD/ilistener.h>
+#include <TDD/observable.h>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <map>
+#include <set>
+#include <tuple>
+#include <typeindex>
+#include <utility>
+#include <vector>
+
+/// Reactive graph of values derived from observables and from each other.
+///
+/// A change of an input marks every node that depends on it as dirty. Nodes
+/// that somebody listens to are then recomputed in order of their rank (their
+/// depth in the graph), and each of them pulls its dirty inputs first. So every
+/// node is recomputed at most once per change, and listeners never see a mix of
+/// old and new inputs. Nodes nobody listens to are only recomputed when they
+/// are read. Inside a reactive::transaction, the recomputation is deferred
+/// until the outermost transaction ends, so any number of assignments costs a
+/// single recomputation per node.
+///
+/// The graph of a thread is propagated by that thread; it is not thread-safe.
+
+template <typename T> class
+dependent_value;
+
+namespace reactive {
+
+    class node;
+
+    /// per-thread propagation state
+    class propagation {
+        friend class node;
+        friend class transaction;
+        
+        template <typename T> friend class source_node;
+        
+        std::vector<node*> scheduled;
+        size_t transactionDepth = 0u;
+        bool propagating = false;
+        std::map<std::pair<const void*,std::type_index>,std::weak_ptr<node>> sources;
+
+        static propagation& current();
+        
+        static bool later(const node* a, const node* b);
+        
+        void schedule(node& n);
+        
+        void unschedule(node& n);
+        
+        void run();
+    };
+
+
+    class node {
+        friend class propagation;
+        
+        size_t rank = 0u;
+        bool scheduled = false;
+        std::vector<node*> dependents;
+        std::vector<std::shared_ptr<node>> upstream;
+        
+        void mark_dirty();
+        
+        virtual void recompute() = 0;
+        
+        virtual bool watched() const = 0;
+        
+    protected:
+        bool dirty = true;
+        
+    public:
+        node() = default;
+        
+        node(const node&) = delete;
+        
+        virtual ~node();
+        
+        void add_upstream(std::shared_ptr<node> up);
+        
+        /// an input of this node has changed
+        void invalidate();
+    };
+
+
+    /// Defers the recomputation of the graph until the outermost transaction ends.
+    class transaction {
+    public:
+        transaction();
+        
+        transaction(const transaction&) = delete;
+        
+        ~transaction();
+    };
+    
+    
+    template <typename T> class
+    value_node final : public node, public iobservable<T> {
+        T value;
+        bool unnotified = false;   ///< recomputed since the listeners were last notified
+        std::function<T()> compute;
+        std::set<ilistener<T>*> listeners;
+        
+        void registerListener_impl(ilistener<T>& l) override;
+        
+        void unregisterListener_impl(ilistener<T>& l) override;
+        
+        void recompute() override;
+        
+        bool watched() const override;
+        
+    public:
+        explicit value_node(std::function<T()> compute);
+        
+        ~value_node();
+        
+        const T& get();
+    };
+    
+    
+    /// Copy of the value of an observable, kept up to date by listening to it.
+    /// All nodes reading the same observable share its source node, so a
+    /// notification dirties all of them before anything is recomputed.
+    template <typename T> class
+    source_node final : public node, public ilistener<T> {
+        T value;
+        std::pair<const void*,std::type_index> key;
+        
+        void handle_impl(T&& val) override;
+        
+        void handle_impl(const T& val) override;
+        
+        void recompute() override {}
+        
+        bool watched() const override { return false; }
+        
+    public:
+        source_node(const T& value, std::pair<const void*,std::type_index> key);
+        
+        ~source_node();
+        
+        template <typename Observable>
+        static std::shared_ptr<source_node> of(Observable& obs);
+        
+        const T& get();
+    };
+    
+    
+    template <typename Input> struct
+    input_traits;
+    
+    template <typename T, typename Policy> struct
+    input_traits<observable<T,Policy>> {
+        using accessor = std::shared_ptr<source_node<T>>;
+        
+        static accessor make(observable<T,Policy>& obs) {
+            return source_node<T>::of(obs);
+        }
+        
+        static void attach(observable<T,Policy>&, const accessor& src, node& n) {
+            n.add_upstream(src);
+        }
+        
+        static T read(const accessor& src) {
+            return src->get();
+        }
+    };
+    
+    template <typename T> struct
+    input_traits<dependent_value<T>> {
+        using accessor = std::shared_ptr<value_node<T>>;
+        
+        static accessor make(dependent_value<T>& dep) {
+            return dep.impl;
+        }
+        
+        static void attach(dependent_value<T>&, const accessor& up, node& n) {
+            n.add_upstream(up);
+        }
+        
+        static T read(const accessor& up) {
+            return up->get();
+        }
+    };
+    
+    
+    template <typename...Inputs> struct
+    inputs {
+        std::tuple<Inputs&...> refs;
+    };
+}
+
+
+/// the inputs of a dependent_value, e.g. dependent_value<double> d(from(a,b), f)
+template <typename...Inputs>
+reactive::inputs<Inputs...> from(Inputs&...ins) {
+    return { std::tuple<Inputs&...>(ins...) };
+}
+
+
+template <typename T> class
+dependent_value : public iobservable<T> {
+    template <typename Input> friend struct reactive::input_traits;
+    
+    std::shared_ptr<reactive::value_node<T>> impl;
+    
+    void registerListener_impl(ilistener<T>& l) override;
+    
+    void unregisterListener_impl(ilistener<T>& l) override;
+    
+    template <typename Callable, typename...Inputs, size_t...I>
+    void build(reactive::inputs<Inputs...> in, Callable fun, std::index_sequence<I...>);
+    
+public:
+    template <typename Callable, typename...Inputs>
+    dependent_value(reactive::inputs<Inputs...> in, Callable fun);
+    
+    template <typename T1, typename Policy, typename Callable>
+    dependent_value(observable<T1,Policy>& obsIn, Callable fun);
+    
+    operator const T& () const;
+};
+
+
+namespace reactive {
+
+    inline propagation& propagation::current() {
+        thread_local propagation p;
+        return p;
+    }
+    
+    /// orders the heap of scheduled nodes with the lowest rank on top
+    inline bool propagation::later(const node* a, const node* b) {
+        return a->rank > b->rank;
+    }
+    
+    inline void propagation::schedule(node& n) {
+        if(n.scheduled)
+            return;
+        n.scheduled = true;
+        scheduled.push_back(&n);
+        std::push_heap(scheduled.begin(), scheduled.end(), later);
+    }
+    
+    inline void propagation::unschedule(node& n) {
+        if(!n.scheduled)
+            return;
+        n.scheduled = false;
+        scheduled.erase(std::remove(scheduled.begin(), scheduled.end(), &n), scheduled.end());
+        std::make_heap(scheduled.begin(), scheduled.end(), later);
+    }
+    
+    inline void propagation::run() {
+        propagating = true;
+        while(!scheduled.empty()) {
+            std::pop_heap(scheduled.begin(), scheduled.end(), later);
+            node* n = scheduled.back();
+            scheduled.pop_back();
+            n->scheduled = false;
+            n->recompute();
+        }
+        propagating = false;
+    }
+    
+    
+    inline node::~node() {
+        propagation::current().unschedule(*this);
+        for(auto& up : upstream) {
+            auto& d = up->dependents;
+            d.erase(std::remove(d.begin(), d.end(), this), d.end());
+        }
+    }
+    
+    inline void node::add_upstream(std::shared_ptr<node> up) {
+        rank = std::max(rank, up->rank + 1u);
+        up->dependents.push_back(this);
+        upstream.push_back(std::move(up));
+    }
+    
+    /// a node that is dirty already has dirty dependents, since reading a node
+    /// always reads all of its inputs first
+    inline void node::mark_dirty() {
+        if(dirty)
+            return;
+        dirty = true;
+        if(watched())
+            propagation::current().schedule(*this);
+        for(auto d : dependents)
+            d->mark_dirty();
+    }
+    
+    inline void node::invalidate() {
+        mark_dirty();
+        auto& p = propagation::current();
+        if(p.transactionDepth == 0u && !p.propagating)
+            p.run();
+    }
+    
+    
+    inline transaction::transaction() {
+        ++propagation::current().transactionDepth;
+    }
+    
+    inline transaction::~transaction() {
+        auto& p = propagation::current();
+        if(--p.transactionDepth == 0u && !p.propagating)
+            p.run();
+    }
+    
+    
+    template <typename T>
+    value_node<T>::value_node(std::function<T()> compute)
+    : value(), compute(std::move(compute))
+    {
+    }
+    
+    template <typename T>
+    value_node<T>::~value_node() {
+        for(auto& l : listeners)
+            l->remove_raii(this);
+    }
+    
+    template <typename T>
+    void value_node<T>::registerListener_impl(ilistener<T>& l) {
+        get();  // a watched node must be clean or scheduled to see the next change
+        listeners.insert(&l);
+        l.add_raii(this,[this,&l]{ this->unregisterListener(l); });
+    }
+    
+    template <typename T>
+    void value_node<T>::unregisterListener_impl(ilistener<T>& l) {
+        listeners.erase(&l);
+    }
+    
+    template <typename T>
+    bool value_node<T>::watched() const {
+        return !listeners.empty();
+    }
+    
+    template <typename T>
+    const T& value_node<T>::get() {
+        if(dirty) {
+            value = compute();
+            dirty = false;
+            unnotified = true;
+        }
+        return value;
+    }
+    
+    /// the node may have been read, and so recomputed, since it was scheduled,
+    /// e.g. inside a transaction or by a listener of a lower-ranked node
+    template <typename T>
+    void value_node<T>::recompute() {
+        const T& val = get();
+        if(!unnotified)
+            return;
+        unnotified = false;
+        for(auto& l : listeners)
+            l->handle(val);
+    }
+    
+    
+    template <typename T>
+    source_node<T>::source_node(const T& value, std::pair<const void*,std::type_index> key)
+    : value(value), key(std::move(key))
+    {
+        dirty = false;
+    }
+    
+    template <typename T>
+    source_node<T>::~source_node() {
+        auto& sources = propagation::current().sources;
+        const auto found = sources.find(key);
+        if(found != sources.end() && found->second.expired())
+            sources.erase(found);
+    }
+    
+    /// an entry is reused only while it is still registered at that very
+    /// observable; the address may belong to a new observable by now
+    template <typename T>
+    template <typename Observable>
+    std::shared_ptr<source_node<T>> source_node<T>::of(Observable& obs) {
+        iobservable<T>* const at = &obs;
+        auto& sources = propagation::current().sources;
+        const auto key = std::make_pair(static_cast<const void*>(at), std::type_index(typeid(T)));
+        auto& entry = sources[key];
+        if(auto existing = std::static_pointer_cast<source_node<T>>(entry.lock()))
+            if(existing->has_raii(at))
+                return existing;
+        auto created = std::make_shared<source_node<T>>(static_cast<const T&>(obs), key);
+        obs.registerListener(*created);
+        entry = created;
+        return created;
+    }
+    
+    template <typename T>
+    const T& source_node<T>::get() {
+        dirty = false;
+        return value;
+    }
+    
+    template <typename T>
+    void source_node<T>::handle_impl(T&& val) {
+        value = std::move(val);
+        invalidate();
+    }
+    
+    template <typename T>
+    void source_node<T>::handle_impl(const T& val) {
+        value = val;
+        invalidate();
+    }
+}
+
+
+template <typename T>
+template <typename Callable, typename...Inputs, size_t...I>
+void dependent_value<T>::build(reactive::inputs<Inputs...> in, Callable fun, std::index_sequence<I...>) {
+    auto accessors = std::make_tuple(reactive::input_traits<Inputs>::make(std::get<I>(in.refs))...);
+    impl = std::make_shared<reactive::value_node<T>>([accessors,fun]() mutable {
+        return T(fun(reactive::input_traits<Inputs>::read(std::get<I>(accessors))...));
+    });
+    using expand = int[];
+    (void)expand{ 0, (reactive::input_traits<Inputs>::attach(std::get<I>(in.refs), std::get<I>(accessors), *impl), 0)... };
+}
+
+template <typename T>
+template <typename Callable, typename...Inputs>
+dependent_value<T>::dependent_value(reactive::inputs<Inputs...> in, Callable fun)
+{
+    build(std::move(in), std::move(fun), std::index_sequence_for<Inputs...>{});
+}
+
+template <typename T>
+template <typename T1, typename Policy, typename Callable>
+dependent_value<T>::dependent_value(observable<T1,Policy>& obsIn, Callable fun)
+    : dependent_value(from(obsIn), std::move(fun))
+{
+}
+
+template <typename T>
+void dependent_value<T>::registerListener_impl(ilistener<T>& l) {
+    impl->registerListener(l);
+}
+
+template <typename T>
+void dependent_value<T>::unregisterListener_impl(ilistener<T>& l) {
+    impl->unregisterListener(l);
+}
+
+template <typename T>
+dependent_value<T>::operator const T& () const {
+    return impl->get();
+}
@@ -0,0 +1,167 @@
+#include <TDD/dependent_value.h>
+#include <TDD/listener.h>
+#include <catch.h>
+#include <string>
+#include <sstream>
+#include <vector>
+
+TEST_CASE("dependent_value","[dependent_value]") {
+    observable<int> obs(1);
+    dependent_value<std::string> value(obs,[](int&& i){
+        return (std::stringstream() << i).str();
+    });
+    
+    WHEN("the value of the dependent value is retrieved") {
+        THEN("the retrieved value it is equal to the behavior applied to the initial value of the observable") {
+            REQUIRE(std::string("1") == static_cast<const std::string&>(value));
+        }
+    }
+    
+    AND_WHEN("assigning the observable a value") {
+        obs = 7;
+        THEN("the dependent value will be updated") {
+            REQUIRE(std::string("7") == static_cast<const std::string&>(value));
+        }
+    }
+}
+
+SCENARIO("dependent values form a glitch-free graph","[dependent_value]") {
+    GIVEN("a diamond a -> (b, c) -> d with a listener on d") {
+        observable<int> a(1);
+        int computedB = 0, computedC = 0, computedD = 0;
+        dependent_value<int> b(a,[&](int x){ ++computedB; return x + 1; });
+        dependent_value<int> c(a,[&](int x){ ++computedC; return x * 2; });
+        dependent_value<int> d(from(b,c),[&](int x, int y){ ++computedD; return x + y; });
+        REQUIRE(4 == static_cast<const int&>(d));
+        
+        std::vector<int> seen;
+        listener<int> l([&](int&& v){ seen.push_back(v); });
+        d.registerListener(l);
+        computedB = computedC = computedD = 0;
+        
+        WHEN("a is assigned") {
+            a = 5;
+            THEN("every node is recomputed once and the listener sees only the consistent result") {
+                REQUIRE(1 == computedB);
+                REQUIRE(1 == computedC);
+                REQUIRE(1 == computedD);
+                REQUIRE(1u == seen.size());
+                REQUIRE(16 == seen.front());
+            }
+        }
+    }
+    
+    GIVEN("two observables feeding a watched sum") {
+        observable<int> x(0), y(0);
+        int computed = 0;
+        dependent_value<int> sum(from(x,y),[&](int a, int b){ ++computed; return a + b; });
+        std::vector<int> seen;
+        listener<int> l([&](int&& v){ seen.push_back(v); });
+        sum.registerListener(l);
+        (void)static_cast<const int&>(sum);
+        computed = 0;
+        
+        WHEN("both are assigned within a transaction") {
+            {
+                reactive::transaction t;
+                x = 1;
+                y = 2;
+                REQUIRE(0 == computed);
+            }
+            THEN("the sum is recomputed and notified once, when the transaction ends") {
+                REQUIRE(1 == computed);
+                REQUIRE(1u == seen.size());
+                REQUIRE(3 == seen.front());
+            }
+        }
+        
+        WHEN("they are assigned without a transaction") {
+            x = 1;
+            y = 2;
+            THEN("every assignment propagates") {
+                REQUIRE(2 == computed);
+                REQUIRE((std::vector<int>{1, 3}) == seen);
+            }
+        }
+        
+        WHEN("the sum is read inside the transaction") {
+            {
+                reactive::transaction t;
+                x = 1;
+                y = 2;
+                REQUIRE(3 == static_cast<const int&>(sum));
+            }
+            THEN("its listener is still notified when the transaction ends") {
+                REQUIRE(1 == computed);
+                REQUIRE((std::vector<int>{3}) == seen);
+            }
+        }
+    }
+    
+    GIVEN("a listener of a lower-ranked node that reads a higher-ranked watched node") {
+        observable<int> a(1);
+        dependent_value<int> low(a,[](int x){ return x + 1; });
+        dependent_value<int> twice(a,[](int x){ return 2 * x; });
+        dependent_value<int> high(from(twice),[](int x){ return x + 1; });
+        
+        std::vector<int> readByLow, seenHigh;
+        listener<int> lowListener([&](int&&){ readByLow.push_back(static_cast<const int&>(high)); });
+        listener<int> highListener([&](int&& v){ seenHigh.push_back(v); });
+        low.registerListener(lowListener);
+        high.registerListener(highListener);
+        
+        WHEN("a is assigned") {
+            a = 5;
+            THEN("the read during propagation does not swallow the notification of the higher node") {
+                REQUIRE((std::vector<int>{11}) == readByLow);
+                REQUIRE((std::vector<int>{11}) == seenHigh);
+            }
+        }
+    }
+    
+    GIVEN("a dependent value nobody listens to") {
+        observable<int> a(1);
+        int computed = 0;
+        dependent_value<int> twice(a,[&](int x){ ++computed; return 2 * x; });
+        REQUIRE(2 == static_cast<const int&>(twice));
+        computed = 0;
+        
+        WHEN("its input changes several times") {
+            a = 2;
+            a = 3;
+            a = 4;
+            THEN("it is recomputed only once it is read") {
+                REQUIRE(0 == computed);
+                REQUIRE(8 == static_cast<const int&>(twice));
+                REQUIRE(1 == computed);
+            }
+        }
+    }
+    
+    GIVEN("a long chain of dependent values") {
+        observable<int> a(0);
+        std::vector<std::unique_ptr<dependent_value<int>>> chain;
+        chain.emplace_back(new dependent_value<int>(a,[](int x){ return x + 1; }));
+        for(int i = 1; i < 200; ++i)
+            chain.emplace_back(new dependent_value<int>(from(*chain.back()),[](int x){ return x + 1; }));
+        int last = 0;
+        listener<int> l([&](int&& v){ last = v; });
+        chain.back()->registerListener(l);
+        
+        WHEN("the source is assigned") {
+            a = 10;
+            THEN("the end of the chain is notified with the propagated value") {
+                REQUIRE(210 == last);
+            }
+        }
+        
+        WHEN("the chain is destroyed from its source end") {
+            while(!chain.empty())
+                chain.erase(chain.begin());
+            a = 1;
+            THEN("assigning the source is still safe") {
+                REQUIRE(0 == last);
+            }
+        }
+    }
+}
@@ -0,0 +1,494 @@
+#pragma once
+#include <TDD/small_function.h>
+#include <TDD/span.h>
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/// Forth for device scripts. Source is compiled once into bytecode: numbers
+/// become literals, the core words become opcodes, words defined in C++ are
+/// called through a table and colon definitions are called by their address
+/// in the code. Names are only looked up while compiling. The inner
+/// interpreter is a loop over the code with fixed-size data and return
+/// stacks, so a compiled program can be run over and over.
+///
+/// Core words: + - * / mod = < > dup drop swap over rot, and inside
+/// definitions or top-level code  : ;  if else then  begin until again
+/// do loop i  ( comment )  \ comment. Comparisons leave -1 for true.
+
+namespace forth {
+    using cell = int32_t;
+
+    struct error : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    class machine;
+
+    using primitive = small_function<void(machine&)>;
+
+    /// compiled top-level code of one compile() call
+    struct program {
+        size_t entry;
+        size_t end;
+    };
+
+    enum class op : cell {
+        lit, call, prim, ret, jump, jump_if_zero, do_loop, loop, index,
+        add, sub, mul, div, mod, eq, lt, gt, dup, drop, swap, over, rot
+    };
+
+    class
+    machine {
+    public:
+        static constexpr size_t stack_size = 256u;
+        static constexpr size_t return_stack_size = 256u;
+
+        machine();
+
+        machine(const machine&) = delete;
+
+        /// adds or replaces a word implemented in C++; code compiled before keeps the old meaning
+        void define(const std::string& name, primitive fun);
+
+        /// compiles the colon definitions into the dictionary and returns the remaining top-level code
+        program compile(span<const char> source);
+
+        program compile(const std::string& source);
+
+        void run(program p);
+
+        /// drops the code of p, if nothing was compiled after it; the definitions stay
+        void forget(program p);
+
+        /// compiles and runs the source once; only its definitions are kept
+        void interpret(const std::string& source);
+
+        void push(cell value);
+
+        cell pop();
+
+        size_t depth() const;
+
+        /// the data stack, bottom first
+        std::vector<cell> stack() const;
+
+        /// cells of bytecode held for definitions and compiled programs
+        size_t code_size() const;
+
+    private:
+        struct word {
+            enum kind_t { builtin, native, colon } kind;
+            cell operand;
+        };
+
+        enum class control { if_, else_, begin, do_ };
+
+        std::unordered_map<std::string, cell> names;
+        std::vector<word> words;
+        std::vector<primitive> primitives;
+        std::vector<cell> code;
+        std::array<cell, stack_size> data;
+        size_t sp = 0u;
+        std::array<cell, return_stack_size> rstack;
+        size_t rp = 0u;
+        std::string scratch;
+
+        void add(const std::string& name, word w);
+
+        const word* find(span<const char> name);
+
+        void rpush(cell value);
+
+        cell rpop();
+
+        void execute(size_t ip);
+    };
+
+
+
+    inline machine::machine() {
+        static const std::pair<const char*, op> core[] = {
+            { "+", op::add }, { "-", op::sub }, { "*", op::mul }, { "/", op::div }, { "mod", op::mod },
+            { "=", op::eq }, { "<", op::lt }, { ">", op::gt },
+            { "dup", op::dup }, { "drop", op::drop }, { "swap", op::swap }, { "over", op::over }, { "rot", op::rot }
+        };
+        for(auto& w : core)
+            add(w.first, { word::builtin, static_cast<cell>(w.second) });
+    }
+
+    inline void machine::add(const std::string& name, word w) {
+        names[name] = static_cast<cell>(words.size());
+        words.push_back(w);
+    }
+
+    inline const machine::word* machine::find(span<const char> name) {
+        scratch.assign(name.data(), name.size());
+        const auto it = names.find(scratch);
+        return it == names.end() ? nullptr : &words[static_cast<size_t>(it->second)];
+    }
+
+    inline void machine::define(const std::string& name, primitive fun) {
+        add(name, { word::native, static_cast<cell>(primitives.size()) });
+        primitives.push_back(std::move(fun));
+    }
+
+    inline program machine::compile(const std::string& source) {
+        return compile(span<const char>(source.data(), source.size()));
+    }
+
+    inline void machine::forget(program p) {
+        if(code.size() == p.end)
+            code.resize(p.entry);
+    }
+
+    inline void machine::interpret(const std::string& source) {
+        const program p = compile(source);
+        try {
+            run(p);
+        } catch(...) {
+            forget(p);
+            throw;
+        }
+        forget(p);
+    }
+
+    namespace detail {
+        inline bool is_space(char c) {
+            return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+        }
+
+        inline bool equals(span<const char> token, const char* str) {
+            size_t i = 0u;
+            for(; i < token.size(); ++i)
+                if(str[i] != token[i])
+                    return false;
+            return str[i] == '\0';
+        }
+
+        inline bool number(span<const char> token, cell& value) {
+            const bool negative = token.size() > 1u && token[0] == '-';
+            long long n = 0;
+            for(size_t i = negative ? 1u : 0u; i < token.size(); ++i) {
+                if(token[i] < '0' || token[i] > '9' || n > 0x80000000LL)
+                    return false;
+                n = 10*n + (token[i] - '0');
+            }
+            n = negative ? -n : n;
+            if(n < std::numeric_limits<cell>::min() || n > std::numeric_limits<cell>::max())
+                return false;
+            value = static_cast<cell>(n);
+            return true;
+        }
+    }
+
+    /// Definitions are compiled into their own buffer and appended to the
+    /// code at ';', top-level code at the end. Jumps are relative to their
+    /// operand so that buffers can be appended as they are.
+    inline program machine::compile(span<const char> source) {
+        using detail::equals;
+        std::vector<cell> top, definition;
+        std::vector<cell>* out = &top;
+        std::vector<std::pair<control, size_t>> open;
+        std::string defining;
+        size_t pos = 0u;
+
+        auto next = [&] {
+            while(pos != source.size() && detail::is_space(source[pos]))
+                ++pos;
+            const size_t start = pos;
+            while(pos != source.size() && !detail::is_space(source[pos]))
+                ++pos;
+            return source.subspan(start, pos - start);
+        };
+        auto fail = [&](const std::string& what, span<const char> token) {
+            throw error(what + " '" + std::string(token.begin(), token.end()) + "'");
+        };
+        auto emit = [&](op o) { out->push_back(static_cast<cell>(o)); };
+        auto forward = [&](op o, control c) {
+            emit(o);
+            open.emplace_back(c, out->size());
+            out->push_back(0);
+        };
+        auto resolve = [&](size_t operand) {
+            (*out)[operand] = static_cast<cell>(out->size() - operand);
+        };
+        auto backward = [&](op o, size_t target) {
+            emit(o);
+            out->push_back(static_cast<cell>(target) - static_cast<cell>(out->size()));
+        };
+        auto close = [&](span<const char> token, std::initializer_list<control> expected) {
+            for(auto c : expected)
+                if(!open.empty() && open.back().first == c) {
+                    const size_t at = open.back().second;
+                    open.pop_back();
+                    return at;
+                }
+            fail("unmatched", token);
+            return size_t(0u);
+        };
+
+        for(auto token = next(); !token.empty(); token = next()) {
+            cell value;
+            if(equals(token, "(")) {
+                while(pos != source.size() && source[pos] != ')')
+                    ++pos;
+                if(pos == source.size())
+                    fail("unterminated comment", token);
+                ++pos;
+            } else if(equals(token, "\\")) {
+                while(pos != source.size() && source[pos] != '\n')
+                    ++pos;
+            } else if(equals(token, ":")) {
+                if(out == &definition || !open.empty())
+                    fail("nested definition at", token);
+                const auto name = next();
+                if(name.empty())
+                    fail("missing name after", token);
+                defining.assign(name.data(), name.size());
+                out = &definition;
+            } else if(equals(token, ";")) {
+                if(out != &definition || !open.empty())
+                    fail("unmatched", token);
+                emit(op::ret);
+                const cell entry = static_cast<cell>(code.size());
+                code.insert(code.end(), definition.begin(), definition.end());
+                definition.clear();
+                add(defining, { word::colon, entry });
+                out = &top;
+            } else if(equals(token, "if")) {
+                forward(op::jump_if_zero, control::if_);
+            } else if(equals(token, "else")) {
+                const size_t at = close(token, { control::if_ });
+                forward(op::jump, control::else_);
+                resolve(at);
+            } else if(equals(token, "then")) {
+                resolve(close(token, { control::if_, control::else_ }));
+            } else if(equals(token, "begin")) {
+                open.emplace_back(control::begin, out->size());
+            } else if(equals(token, "until")) {
+                backward(op::jump_if_zero, close(token, { control::begin }));
+            } else if(equals(token, "again")) {
+                backward(op::jump, close(token, { control::begin }));
+            } else if(equals(token, "do")) {
+                emit(op::do_loop);
+                open.emplace_back(control::do_, out->size());
+            } else if(equals(token, "loop")) {
+                backward(op::loop, close(token, { control::do_ }));
+            } else if(equals(token, "i")) {
+                bool in_loop = false;
+                for(auto& c : open)
+                    in_loop = in_loop || c.first == control::do_;
+                if(!in_loop)
+                    fail("outside of do ... loop:", token);
+                emit(op::index);
+            } else if(detail::number(token, value)) {
+                emit(op::lit);
+                out->push_back(value);
+            } else if(const word* w = find(token)) {
+                switch(w->kind) {
+                    case word::builtin:
+                        out->push_back(w->operand);
+                        break;
+                    case word::native:
+                        emit(op::prim);
+                        out->push_back(w->operand);
+                        break;
+                    case word::colon:
+                        emit(op::call);
+                        out->push_back(w->operand);
+                        break;
+                }
+            } else {
+                fail("unknown word", token);
+            }
+        }
+        if(out == &definition)
+            throw error("unterminated definition '" + defining + "'");
+        if(!open.empty())
+            throw error("unterminated control structure");
+
+        emit(op::ret);
+        const size_t entry = code.size();
+        code.insert(code.end(), top.begin(), top.end());
+        return { entry, code.size() };
+    }
+
+    inline void machine::push(cell value) {
+        if(sp == stack_size)
+            throw error("stack overflow");
+        data[sp++] = value;
+    }
+
+    inline cell machine::pop() {
+        if(sp == 0u)
+            throw error("stack underflow");
+        return data[--sp];
+    }
+
+    inline size_t machine::depth() const {
+        return sp;
+    }
+
+    inline std::vector<cell> machine::stack() const {
+        return std::vector<cell>(data.begin(), data.begin() + sp);
+    }
+
+    inline size_t machine::code_size() const {
+        return code.size();
+    }
+
+    inline void machine::rpush(cell value) {
+        if(rp == return_stack_size)
+            throw error("return stack overflow");
+        rstack[rp++] = value;
+    }
+
+    inline cell machine::rpop() {
+        return rstack[--rp];
+    }
+
+    /// the return stack is unwound if a word throws; the data stack is left as it was
+    inline void machine::run(program p) {
+        const size_t base = rp;
+        try {
+            execute(p.entry);
+        } catch(...) {
+            rp = base;
+            throw;
+        }
+    }
+
+    inline void machine::execute(size_t ip) {
+        const size_t base = rp;
+        auto wrap = [](int64_t v) { return static_cast<cell>(static_cast<uint32_t>(v)); };
+        for(;;) {
+            switch(static_cast<op>(code[ip++])) {
+                case op::lit:
+                    push(code[ip++]);
+                    break;
+                case op::call:
+                    rpush(static_cast<cell>(ip + 1u));
+                    ip = static_cast<size_t>(code[ip]);
+                    break;
+                case op::prim:
+                    primitives[static_cast<size_t>(code[ip++])](*this);
+                    break;
+                case op::ret:
+                    if(rp == base)
+                        return;
+                    ip = static_cast<size_t>(rpop());
+                    break;
+                case op::jump:
+                    ip += code[ip];
+                    break;
+                case op::jump_if_zero:
+                    ip += pop() == 0 ? code[ip] : 1;
+                    break;
+                case op::do_loop: {
+                    const cell index = pop();
+                    const cell limit = pop();
+                    rpush(limit);
+                    rpush(index);
+                    break;
+                }
+                case op::loop:
+                    if(++rstack[rp - 1u] < rstack[rp - 2u]) {
+                        ip += code[ip];
+                    } else {
+                        rp -= 2u;
+                        ++ip;
+                    }
+                    break;
+                case op::index:
+                    push(rstack[rp - 1u]);
+                    break;
+                case op::add: {
+                    const cell b = pop();
+                    push(wrap(int64_t(pop()) + b));
+                    break;
+                }
+                case op::sub: {
+                    const cell b = pop();
+                    push(wrap(int64_t(pop()) - b));
+                    break;
+                }
+                case op::mul: {
+                    const cell b = pop();
+                    push(wrap(int64_t(pop()) * b));
+                    break;
+                }
+                case op::div: {
+                    const cell b = pop();
+                    const cell a = pop();
+                    if(b == 0)
+                        throw error("division by zero");
+                    push(b == -1 ? wrap(-int64_t(a)) : a / b);
+                    break;
+                }
+                case op::mod: {
+                    const cell b = pop();
+                    const cell a = pop();
+                    if(b == 0)
+                        throw error("division by zero");
+                    push(b == -1 ? 0 : a % b);
+                    break;
+                }
+                case op::eq: {
+                    const cell b = pop();
+                    push(pop() == b ? -1 : 0);
+                    break;
+                }
+                case op::lt: {
+                    const cell b = pop();
+                    push(pop() < b ? -1 : 0);
+                    break;
+                }
+                case op::gt: {
+                    const cell b = pop();
+                    push(pop() > b ? -1 : 0);
+                    break;
+                }
+                case op::dup: {
+                    const cell a = pop();
+                    push(a);
+                    push(a);
+                    break;
+                }
+                case op::drop:
+                    pop();
+                    break;
+                case op::swap: {
+                    const cell b = pop();
+                    const cell a = pop();
+                    push(b);
+                    push(a);
+                    break;
+                }
+                case op::over: {
+                    const cell b = pop();
+                    const cell a = pop();
+                    push(a);
+                    push(b);
+                    push(a);
+                    break;
+                }
+                case op::rot: {
+                    const cell c = pop();
+                    const cell b = pop();
+                    const cell a = pop();
+                    push(b);
+                    push(c);
+                    push(a);
+                    break;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,120 @@
+#include <TDD/forth.h>
+#include <catch.h>
+#include <string>
+#include <vector>
+
+namespace {
+    std::vector<forth::cell> run(forth::machine& m, const std::string& source) {
+        m.interpret(source);
+        return m.stack();
+    }
+}
+
+TEST_CASE("forth") {
+    forth::machine m;
+    
+    SECTION("0") {
+        CHECK(run(m, "0") == std::vector<forth::cell>{0});
+    }
+    
+    SECTION("1") {
+        CHECK(run(m, "1") == std::vector<forth::cell>{1});
+    }
+    
+    SECTION("1 2") {
+        CHECK(run(m, "1 2") == std::vector<forth::cell>({1, 2}));
+    }
+    
+    SECTION("1 2 +") {
+        CHECK(run(m, "1 2 +") == std::vector<forth::cell>({3}));
+    }
+    
+    SECTION("10 2 - 100 +") {
+        CHECK(run(m, "10 2 - 100 +") == std::vector<forth::cell>({108}));
+    }
+    
+    SECTION("-7 2 / -7 2 mod 3 4 *") {
+        CHECK(run(m, "-7 2 / -7 2 mod 3 4 *") == std::vector<forth::cell>({-3, -1, 12}));
+    }
+    
+    SECTION("stack words") {
+        CHECK(run(m, "1 2 3 rot over swap drop dup") == std::vector<forth::cell>({2, 3, 3, 3}));
+    }
+    
+    SECTION(": plus6 1 + 5 + ; 3 plus6") {
+        CHECK(run(m, ": plus6 1 + 5 + ; 3 plus6") == std::vector<forth::cell>({9}));
+    }
+    
+    SECTION("definitions longer than 100 characters") {
+        std::string body;
+        for(int i = 0; i < 60; ++i)
+            body += " 1 +";
+        CHECK(run(m, ": plus60" + body + " ; 0 plus60") == std::vector<forth::cell>({60}));
+    }
+    
+    SECTION("definitions calling definitions") {
+        CHECK(run(m, ": sq dup * ; : sum-sq sq swap sq + ; 3 4 sum-sq") == std::vector<forth::cell>({25}));
+    }
+    
+    SECTION("if else then") {
+        m.interpret(": sign dup 0 < if drop -1 else 0 > if 1 else 0 then then ;");
+        CHECK(run(m, "-5 sign 0 sign 7 sign") == std::vector<forth::cell>({-1, 0, 1}));
+    }
+    
+    SECTION("do loop") {
+        CHECK(run(m, ": sum 0 swap 0 do i + loop ; 100 sum") == std::vector<forth::cell>({4950}));
+    }
+    
+    SECTION("begin until") {
+        CHECK(run(m, ": countdown begin 1 - dup 0 = until ; 5 countdown") == std::vector<forth::cell>({0}));
+    }
+    
+    SECTION("comments") {
+        CHECK(run(m, "1 ( two ) 2 \\ three\n 4") == std::vector<forth::cell>({1, 2, 4}));
+    }
+    
+    SECTION("redefinitions only affect code compiled afterwards") {
+        m.interpret(": x 1 ; : y x ; : x 2 ;");
+        CHECK(run(m, "y x") == std::vector<forth::cell>({1, 2}));
+    }
+    
+    SECTION("words implemented in C++") {
+        int calls = 0;
+        m.define("count", [&calls](forth::machine& m) { m.push(++calls); });
+        CHECK(run(m, ": twice count count ; twice +") == std::vector<forth::cell>({3}));
+    }
+    
+    SECTION("a compiled program runs again without recompiling") {
+        m.interpret(": step dup 1 + ;");
+        const auto program = m.compile("step swap drop");
+        m.push(0);
+        for(int i = 0; i < 1000; ++i)
+            m.run(program);
+        REQUIRE(m.depth() == 1u);
+        REQUIRE(m.pop() == 1000);
+    }
+    
+    SECTION("interpreted top-level code is not kept") {
+        m.interpret(": step 1 + ;");
+        const size_t size = m.code_size();
+        for(int i = 0; i < 1000; ++i)
+            m.interpret("0 step step drop");
+        REQUIRE_THROWS_AS(m.interpret("step"), forth::error);
+        REQUIRE(m.code_size() == size);
+        CHECK(run(m, "0 step") == std::vector<forth::cell>({1}));
+    }
+    
+    SECTION("errors") {
+        REQUIRE_THROWS_AS(m.compile("1 frobnicate"), forth::error);
+        REQUIRE_THROWS_AS(m.compile(": broken 1 if 2 ;"), forth::error);
+        REQUIRE_THROWS_AS(m.compile("1 then"), forth::error);
+        REQUIRE_THROWS_AS(m.compile(": unfinished 1 2"), forth::error);
+        REQUIRE_THROWS_AS(m.compile("i"), forth::error);
+        REQUIRE_THROWS_AS(m.interpret("1 +"), forth::error);
+        REQUIRE_THROWS_AS(m.interpret("1 0 /"), forth::error);
+        REQUIRE_THROWS_AS(m.interpret(": deep 1 deep-er ;"), forth::error);
+        m.interpret(": overflow begin 1 0 until ;");
+        REQUIRE_THROWS_AS(m.interpret("overflow"), forth::error);
+        REQUIRE(m.depth() == size_t(forth::machine::stack_size));
+    }
+}
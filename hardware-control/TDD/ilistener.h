@@ -1,6 +1,7 @@
 #pragma once
 #include <TDD/with_destructor.h>
 #include <TDD/inotifyable.h>
+#include <TDD/intrusive_hook.h>
 
 template <typename T> struct
 iobservable;
@@ -9,6 +10,7 @@ iobservable;
 template <typename T> struct
 ilistener
     : inotifyable<T>,
-      with_destructor<iobservable<T>*>
+      inline_with_destructor<iobservable<T>*>,
+      intrusive_hook<ilistener<T>>
 {
-};
\ No newline at end of file
+};
@@ -5,8 +5,15 @@ template <typename T> struct
 inotifyable {
     void handle(T&& val);
     
+    void handle(const T& val);
+    
 private:
     virtual void handle_impl(T&&) = 0;
+    
+    /// Notifications that share one value between several receivers arrive here.
+    /// The default hands a copy to handle_impl(T&&); receivers that only read
+    /// the value override this to avoid the copy.
+    virtual void handle_impl(const T& val);
 };
 
 
@@ -14,3 +21,13 @@ template <typename T>
 void inotifyable<T>::handle(T&& val) {
     handle_impl(std::move(val));
 }
+
+template <typename T>
+void inotifyable<T>::handle(const T& val) {
+    handle_impl(val);
+}
+
+template <typename T>
+void inotifyable<T>::handle_impl(const T& val) {
+    handle_impl(T(val));
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+/// Node of an intrusive, circular doubly-linked list. Linking and unlinking
+/// are pointer splices that never allocate. A hook unlinks itself when it is
+/// destroyed, and copies of a hook start out unlinked.
+/// The Tag keeps the hooks of unrelated lists apart when a class derives from
+/// several hooks.
+template <typename Tag> class
+intrusive_hook {
+    intrusive_hook* prev;
+    intrusive_hook* next;
+
+public:
+    intrusive_hook();
+
+    intrusive_hook(const intrusive_hook&);
+
+    intrusive_hook& operator= (const intrusive_hook&);
+
+    ~intrusive_hook();
+
+    bool is_linked() const;
+
+    /// inserts this hook in front of 'pos', unlinking it from its current list first
+    void link_before(intrusive_hook& pos);
+
+    void unlink();
+
+    /// moves all hooks linked behind the sentinel 'other' behind this sentinel
+    void take_over(intrusive_hook& other);
+
+    intrusive_hook* next_hook() const;
+};
+
+
+template <typename Tag>
+intrusive_hook<Tag>::intrusive_hook()
+: prev(this), next(this)
+{
+}
+
+template <typename Tag>
+intrusive_hook<Tag>::intrusive_hook(const intrusive_hook&)
+: prev(this), next(this)
+{
+}
+
+template <typename Tag>
+intrusive_hook<Tag>& intrusive_hook<Tag>::operator= (const intrusive_hook&) {
+    return *this;
+}
+
+template <typename Tag>
+intrusive_hook<Tag>::~intrusive_hook() {
+    unlink();
+}
+
+template <typename Tag>
+bool intrusive_hook<Tag>::is_linked() const {
+    return next != this;
+}
+
+template <typename Tag>
+void intrusive_hook<Tag>::link_before(intrusive_hook& pos) {
+    unlink();
+    prev = pos.prev;
+    next = &pos;
+    pos.prev->next = this;
+    pos.prev = this;
+}
+
+template <typename Tag>
+void intrusive_hook<Tag>::unlink() {
+    prev->next = next;
+    next->prev = prev;
+    prev = next = this;
+}
+
+template <typename Tag>
+void intrusive_hook<Tag>::take_over(intrusive_hook& other) {
+    unlink();
+    if(!other.is_linked())
+        return;
+    prev = other.prev;
+    next = other.next;
+    prev->next = this;
+    next->prev = this;
+    other.prev = other.next = &other;
+}
+
+template <typename Tag>
+intrusive_hook<Tag>* intrusive_hook<Tag>::next_hook() const {
+    return next;
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <TDD/iobservable.h>
+#include <TDD/ilistener.h>
+#include <utility>
+
+
+/// Observable that links its listeners through the intrusive hook embedded in
+/// ilistener, so registering and unregistering never allocate. Each listener
+/// has a single hook and can therefore be registered at one
+/// intrusive_observable at a time; registering it elsewhere moves it.
+/// While listeners are notified, a listener may unregister itself, but no
+/// other listener.
+template <typename T>
+class intrusive_observable : public iobservable<T> {
+    using hook_type = intrusive_hook<ilistener<T>>;
+
+    T value;
+    hook_type listeners;
+
+    void registerListener_impl(ilistener<T>& l) override;
+
+    void unregisterListener_impl(ilistener<T>& l) override;
+
+    void unlinkAll();
+
+public:
+    explicit intrusive_observable(T value);
+
+    intrusive_observable(const intrusive_observable& other) = delete;
+
+    intrusive_observable(intrusive_observable&& other);
+
+    intrusive_observable& operator = (const intrusive_observable& other) = delete;
+
+    intrusive_observable& operator = (intrusive_observable&& other);
+
+    ~intrusive_observable();
+
+    intrusive_observable& operator=(const T& val);
+
+    intrusive_observable& operator=(T&& val);
+
+    operator const T& () const;
+
+private:
+    void notify();
+};
+
+
+template <typename T>
+void intrusive_observable<T>::registerListener_impl(ilistener<T>& l) {
+    static_cast<hook_type&>(l).link_before(listeners);
+}
+
+template <typename T>
+void intrusive_observable<T>::unregisterListener_impl(ilistener<T>& l) {
+    static_cast<hook_type&>(l).unlink();
+}
+
+template <typename T>
+void intrusive_observable<T>::unlinkAll() {
+    while(listeners.is_linked())
+        listeners.next_hook()->unlink();
+}
+
+template <typename T>
+intrusive_observable<T>::intrusive_observable(T value)
+: value(std::move(value))
+{
+}
+
+template <typename T>
+intrusive_observable<T>::intrusive_observable(intrusive_observable&& other)
+: value(std::move(other.value))
+{
+    listeners.take_over(other.listeners);
+}
+
+template <typename T>
+intrusive_observable<T>& intrusive_observable<T>::operator = (intrusive_observable&& other) {
+    if(this != &other) {
+        unlinkAll();
+        value = std::move(other.value);
+        listeners.take_over(other.listeners);
+    }
+    return *this;
+}
+
+template <typename T>
+intrusive_observable<T>::~intrusive_observable() {
+    unlinkAll();
+}
+
+template <typename T>
+intrusive_observable<T>& intrusive_observable<T>::operator=(const T& val) {
+    value = val;
+    notify();
+    return *this;
+}
+
+template <typename T>
+intrusive_observable<T>& intrusive_observable<T>::operator=(T&& val) {
+    value = std::move(val);
+    notify();
+    return *this;
+}
+
+template <typename T>
+void intrusive_observable<T>::notify() {
+    const T& val = value;
+    for(auto hook = listeners.next_hook(); hook != &listeners; ) {
+        const auto next = hook->next_hook();
+        static_cast<ilistener<T>*>(hook)->handle(val);
+        hook = next;
+    }
+}
+
+template <typename T>
+intrusive_observable<T>::operator const T& () const {
+    return value;
+}
@@ -0,0 +1,148 @@
+#include <TDD/intrusive_observable.h>
+#include <catch.h>
+#include <memory>
+
+namespace {
+
+struct test_listener final : ilistener<int> {
+    int value = 0;
+    size_t triggered = 0u;
+private:
+    void handle_impl(int&& i) override {
+        value = i;
+        ++triggered;
+    }
+};
+
+}
+
+
+TEST_CASE("Assigning value to an intrusive_observable triggers all listeners", "[intrusive_observable]") {
+    GIVEN("an intrusive_observable<int> and several listeners") {
+        test_listener lstnr1, lstnr2, lstnr3;
+        intrusive_observable<int> obs(0);
+        obs.registerListener(lstnr1);
+        obs.registerListener(lstnr2);
+        obs.registerListener(lstnr3);
+        
+        WHEN("a value is assigned") {
+            obs = 42;
+            THEN("all registered listeners are triggered with that value") {
+                REQUIRE(lstnr1.value == 42);
+                REQUIRE(lstnr2.value == 42);
+                REQUIRE(lstnr3.value == 42);
+                REQUIRE(42 == obs);
+            }
+        }
+        
+        WHEN("a listener unregisters and a value is assigned") {
+            obs.unregisterListener(lstnr2);
+            obs = 42;
+            THEN("only the listeners still registered are triggered") {
+                REQUIRE(lstnr1.triggered == 1u);
+                REQUIRE(lstnr2.triggered == 0u);
+                REQUIRE(lstnr3.triggered == 1u);
+            }
+        }
+    }
+}
+
+
+TEST_CASE("Registering a listener at a second intrusive_observable moves the subscription", "[intrusive_observable]") {
+    test_listener lstnr;
+    intrusive_observable<int> obs1(0), obs2(0);
+    obs1.registerListener(lstnr);
+    obs2.registerListener(lstnr);
+    
+    obs1 = 1;
+    REQUIRE(lstnr.triggered == 0u);
+    obs2 = 2;
+    REQUIRE(lstnr.triggered == 1u);
+    REQUIRE(lstnr.value == 2);
+}
+
+
+TEST_CASE("destroying listener before intrusive_observable must be safe", "[intrusive_observable]") {
+    auto obs = std::make_shared<intrusive_observable<int>>(0);
+    auto lstnr1 = std::make_shared<test_listener>();
+    auto lstnr2 = std::make_shared<test_listener>();
+    obs->registerListener(*lstnr1);
+    obs->registerListener(*lstnr2);
+    
+    WHEN("a listener is destroyed and the observable triggered") {
+        lstnr1 = nullptr;
+        *obs = 37;
+        THEN("the remaining listener is still triggered") {
+            REQUIRE(lstnr2->triggered == 1u);
+        }
+    }
+}
+
+
+TEST_CASE("destroying intrusive_observable before listener must be safe", "[intrusive_observable]") {
+    auto obs = new intrusive_observable<int>(0);
+    auto lstnr = new test_listener();
+    obs->registerListener(*lstnr);
+    delete obs;
+    REQUIRE(!static_cast<intrusive_hook<ilistener<int>>&>(*lstnr).is_linked());
+    delete lstnr;
+}
+
+
+TEST_CASE("moving an intrusive_observable keeps the listeners intact", "[intrusive_observable]") {
+    intrusive_observable<int> obs(0);
+    auto lstnr = std::make_shared<test_listener>();
+    obs.registerListener(*lstnr);
+    
+    WHEN("the observable is move-constructed into a different observable") {
+        intrusive_observable<int> obs2(std::move(obs));
+        THEN("modifying the moved-to observable will trigger the listener") {
+            obs2 = 42;
+            REQUIRE(lstnr->triggered == 1u);
+        }
+        AND_THEN("modifying the moved-from observable does not") {
+            obs = 42;
+            REQUIRE(lstnr->triggered == 0u);
+        }
+    }
+    
+    WHEN("the observable is move-assigned to a different observable") {
+        test_listener other;
+        intrusive_observable<int> obs2(0);
+        obs2.registerListener(other);
+        obs2 = std::move(obs);
+        THEN("the listeners of the moved-from observable are taken over") {
+            obs2 = 42;
+            REQUIRE(lstnr->triggered == 1u);
+        }
+        AND_THEN("the previous listeners of the moved-to observable are dropped") {
+            obs2 = 42;
+            REQUIRE(other.triggered == 0u);
+        }
+    }
+}
+
+
+TEST_CASE("a listener may unregister itself while being notified", "[intrusive_observable]") {
+    struct self_removing_listener final : ilistener<int> {
+        intrusive_observable<int>* obs = nullptr;
+        size_t triggered = 0u;
+    private:
+        void handle_impl(int&&) override {
+            ++triggered;
+            obs->unregisterListener(*this);
+        }
+    };
+    
+    intrusive_observable<int> obs(0);
+    self_removing_listener lstnr1;
+    test_listener lstnr2;
+    lstnr1.obs = &obs;
+    obs.registerListener(lstnr1);
+    obs.registerListener(lstnr2);
+    
+    obs = 1;
+    obs = 2;
+    REQUIRE(lstnr1.triggered == 1u);
+    REQUIRE(lstnr2.triggered == 2u);
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <TDD/with_destructor.h>
+#include <functional>
+#include <utility>
+
+/// Runs work on behalf of a task id. Tasks scheduled for the same id run in
+/// the order they were scheduled. After unschedule(id) returns, no task of
+/// that id is pending or running any more (unless unschedule is called from
+/// within such a task).
+template <typename TaskId> struct
+ischeduler : with_destructor<TaskId> {
+    template <typename Callable>
+    void schedule(TaskId task_id, Callable&& fun) {
+        schedule_impl(std::move(task_id), std::forward<Callable>(fun));
+    }
+
+    void unschedule(TaskId task_id) {
+        unschedule_impl(std::move(task_id));
+    }
+    
+private:
+    virtual void schedule_impl(TaskId task_id, std::function<void()> f) = 0;
+    virtual void unschedule_impl(TaskId task_id) = 0;
+};
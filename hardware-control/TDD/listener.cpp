@@ -7,6 +7,8 @@
 //
 
 #include <TDD/listener.h>
+#include <TDD/observable.h>
+#include <string>
 #include <catch.h>
 
 
@@ -19,3 +21,13 @@ TEST_CASE( "Create a listener", "[listener]" ) {
     }
 }
 
+
+
+TEST_CASE( "A listener reading const T& does not need a copy", "[listener]" ) {
+    observable<std::string> obs("");
+    const std::string* seen = nullptr;
+    listener<std::string> reader([&seen](const std::string& s){ seen = &s; });
+    obs.registerListener(reader);
+    obs = std::string("value");
+    REQUIRE(seen == &static_cast<const std::string&>(obs));
+}
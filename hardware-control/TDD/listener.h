@@ -1,19 +1,44 @@
 #pragma once
 #include <TDD/ilistener.h>
 #include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
 
+template <typename LAMBDA, typename T, typename = void> struct
+reads_const_ref : std::false_type {};
+
+template <typename LAMBDA, typename T> struct
+reads_const_ref<LAMBDA, T, decltype(void(std::declval<LAMBDA&>()(std::declval<const T&>())))> : std::true_type {};
+
+
+/// Listener whose behavior is given by a callable. Values handed over with
+/// 'T&&' are moved into the callable, e.g. into a by-value parameter. Shared
+/// values reach a callable that accepts 'const T&' without a copy; one that
+/// only accepts 'T&&' gets a copy of its own.
 template <typename T>
 class listener final : public ilistener<T> {
     std::function<void(T&&)> behavior;
+    std::function<void(const T&)> readBehavior;   ///< set if the callable accepts const T&
     
     virtual void handle_impl(T&& arg) override;
 
+    virtual void handle_impl(const T& arg) override;
+
+    template <typename LAMBDA>
+    void assign(LAMBDA&& lam, std::true_type);
+
+    template <typename LAMBDA>
+    void assign(LAMBDA&& lam, std::false_type);
+
 public:
     template <typename LAMBDA>
     listener(LAMBDA lam);
     
     listener(const listener& other) = delete;
     
+    /// unregisters before the callable is destroyed, so an observable that
+    /// notifies from another thread is done with it first
     ~listener();
 };
 
@@ -23,14 +48,38 @@ void listener<T>::handle_impl(T&& arg) {
     behavior(std::move(arg));
 }
 
+template <typename T>
+void listener<T>::handle_impl(const T& arg) {
+    if(readBehavior)
+        readBehavior(arg);
+    else
+        behavior(T(arg));
+}
+
+/// both paths call the one callable, so a stateful callable keeps one state
+template <typename T>
+template <typename LAMBDA>
+void listener<T>::assign(LAMBDA&& lam, std::true_type) {
+    auto fun = std::make_shared<std::decay_t<LAMBDA>>(std::forward<LAMBDA>(lam));
+    behavior = [fun](T&& arg) { (*fun)(std::move(arg)); };
+    readBehavior = [fun](const T& arg) { (*fun)(arg); };
+}
+
+template <typename T>
+template <typename LAMBDA>
+void listener<T>::assign(LAMBDA&& lam, std::false_type) {
+    behavior = std::forward<LAMBDA>(lam);
+}
+
 template <typename T>
 template <typename LAMBDA>
 listener<T>::listener(LAMBDA lam)
-  : behavior(std::forward<LAMBDA>(lam))
 {
+    assign(std::move(lam), reads_const_ref<LAMBDA,T>{});
 }
 
 
 template <typename T>
 listener<T>::~listener() {
-}
\ No newline at end of file
+    this->run_raii();
+}
@@ -0,0 +1,165 @@
+#pragma once
+#include <TDD/span.h>
+#include <TDD/streams.hpp>
+#include <cerrno>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// Records of a recorded file, read through a sliding memory-mapped window
+/// so files larger than memory can be replayed without copying.
+///
+/// Iterating the file yields one span of records per window. Window offsets
+/// are multiples of both the page size and the record size, so no record
+/// straddles two windows. A span is valid as long as the iterator it came
+/// from (or a copy of it) stays on that window. A trailing partial record
+/// is ignored.
+template <typename Record> class
+record_file {
+    static_assert(std::is_trivially_copyable<Record>::value, "records are read from the file as they are");
+    
+    struct descriptor {
+        int fd;
+        ~descriptor() { ::close(fd); }
+    };
+    
+    struct mapping {
+        void* addr;
+        size_t length;
+        mapping(void* addr, size_t length) : addr(addr), length(length) {}
+        mapping(const mapping&) = delete;
+        ~mapping() { ::munmap(addr, length); }
+    };
+    
+    std::shared_ptr<descriptor> file;
+    size_t recordCount = 0u;
+    size_t windowRecords = 0u;
+    
+    std::shared_ptr<const mapping> map(size_t firstRecord, size_t count) const;
+    
+public:
+    /// the window is rounded up to a multiple of the page and record size
+    explicit record_file(const std::string& path, size_t windowBytes = size_t(64u) << 20);
+    
+    size_t size() const { return recordCount; }
+    
+    size_t records_per_window() const { return windowRecords; }
+    
+    class iterator {
+        const record_file* owner;
+        size_t first;
+        mutable std::shared_ptr<const mapping> window;
+        
+        size_t count() const { return std::min(owner->windowRecords, owner->recordCount - first); }
+        
+    public:
+        using value_type = span<const Record>;
+        using difference_type = std::ptrdiff_t;
+        using reference = span<const Record>;
+        using pointer = void;
+        using iterator_category = std::input_iterator_tag;
+        
+        iterator(const record_file* owner, size_t first) : owner(owner), first(first) {}
+        
+        /// index of the window's first record
+        size_t position() const { return first; }
+        
+        span<const Record> operator* () const {
+            if(!window)
+                window = owner->map(first, count());
+            return { static_cast<const Record*>(window->addr), count() };
+        }
+        
+        iterator& operator++() {
+            first += count();
+            window = nullptr;
+            return *this;
+        }
+        
+        friend bool operator == (const iterator& a, const iterator& b) { return a.first == b.first; }
+        
+        friend bool operator != (const iterator& a, const iterator& b) { return a.first != b.first; }
+    };
+    
+    iterator begin() const { return { this, 0u }; }
+    
+    iterator end() const { return { this, recordCount }; }
+    
+    /// iterates the records one by one, e.g. to wrap them into an input_stream;
+    /// each copy maps its own window, so copies iterate independently
+    class record_iterator {
+        iterator window;
+        mutable span<const Record> records;
+        size_t pos = 0u;
+        
+        const span<const Record>& current() const {
+            if(records.empty())
+                records = *window;
+            return records;
+        }
+        
+    public:
+        using value_type = Record;
+        using difference_type = std::ptrdiff_t;
+        using reference = const Record&;
+        using pointer = const Record*;
+        using iterator_category = std::forward_iterator_tag;
+        
+        explicit record_iterator(iterator window) : window(std::move(window)) {}
+        
+        const Record& operator* () const { return current()[pos]; }
+        
+        const Record* operator-> () const { return &current()[pos]; }
+        
+        record_iterator& operator++() {
+            if(++pos == current().size()) {
+                ++window;
+                pos = 0u;
+                records = {};
+            }
+            return *this;
+        }
+        
+        friend bool operator == (const record_iterator& a, const record_iterator& b) { return a.window.position() + a.pos == b.window.position() + b.pos; }
+        
+        friend bool operator != (const record_iterator& a, const record_iterator& b) { return !(a == b); }
+    };
+    
+    range<record_iterator> records() const { return { record_iterator(begin()), record_iterator(end()) }; }
+};
+
+
+template <typename Record>
+record_file<Record>::record_file(const std::string& path, size_t windowBytes) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        throw std::system_error(errno, std::generic_category(), "record_file: cannot open " + path);
+    file.reset(new descriptor{ fd });
+    struct stat info;
+    if(::fstat(fd, &info) != 0)
+        throw std::system_error(errno, std::generic_category(), "record_file: cannot stat " + path);
+    recordCount = static_cast<size_t>(info.st_size) / sizeof(Record);
+    
+    size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    size_t step = page;
+    while(step % sizeof(Record))
+        step += page;
+    const size_t steps = std::max<size_t>(1u, (windowBytes + step - 1u) / step);
+    windowRecords = steps * step / sizeof(Record);
+}
+
+template <typename Record>
+std::shared_ptr<const typename record_file<Record>::mapping> record_file<Record>::map(size_t firstRecord, size_t count) const {
+    const size_t length = count * sizeof(Record);
+    void* addr = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file->fd, static_cast<off_t>(firstRecord * sizeof(Record)));
+    if(addr == MAP_FAILED)
+        throw std::system_error(errno, std::generic_category(), "record_file: cannot map");
+    ::madvise(addr, length, MADV_SEQUENTIAL);
+    return std::shared_ptr<const mapping>(new mapping(addr, length));
+}
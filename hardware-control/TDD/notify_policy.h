@@ -0,0 +1,98 @@
+#pragma once
+#include <chrono>
+#include <utility>
+
+/// Notification policies decide for an observable whether an assignment is
+/// passed on to the listeners right away (on_assign) and whether a suppressed
+/// value is due later on (on_poll). Values that are due later are delivered
+/// when the owner of the observable calls poll(), e.g. from its GUI tick or
+/// control loop, since observables have no thread of their own.
+
+
+/// Notifies on every assignment.
+struct notify_always {
+    template <typename T>
+    bool on_assign(const T&, const T&) { return true; }
+
+    bool on_poll() { return false; }
+};
+
+
+/// Suppresses assignments that leave the value unchanged and passes all
+/// others on to the wrapped policy.
+template <typename Policy = notify_always> struct
+notify_on_change : Policy {
+    using Policy::Policy;
+
+    notify_on_change(Policy policy = Policy{}) : Policy(std::move(policy)) {}
+
+    template <typename T>
+    bool on_assign(const T& previous, const T& current) {
+        if(previous == current)
+            return false;
+        return Policy::on_assign(previous, current);
+    }
+};
+
+
+/// Leading-edge rate limit: notifies at most once per interval. The latest
+/// value suppressed within an interval is due once the interval has passed.
+template <typename Clock = std::chrono::steady_clock> class
+throttle {
+    typename Clock::duration interval;
+    typename Clock::time_point lastNotified;
+    bool notified = false;
+    bool pending = false;
+
+public:
+    explicit throttle(typename Clock::duration interval) : interval(interval) {}
+
+    template <typename T>
+    bool on_assign(const T&, const T&) {
+        const auto now = Clock::now();
+        if(!notified || now - lastNotified >= interval) {
+            lastNotified = now;
+            notified = true;
+            pending = false;
+            return true;
+        }
+        pending = true;
+        return false;
+    }
+
+    bool on_poll() {
+        const auto now = Clock::now();
+        if(!pending || now - lastNotified < interval)
+            return false;
+        lastNotified = now;
+        pending = false;
+        return true;
+    }
+};
+
+
+/// Trailing-edge debounce: never notifies on assignment; the latest value is
+/// due once no assignment has happened for the quiet period.
+template <typename Clock = std::chrono::steady_clock> class
+debounce {
+    typename Clock::duration quiet;
+    typename Clock::time_point lastAssigned;
+    bool pending = false;
+
+public:
+    explicit debounce(typename Clock::duration quiet) : quiet(quiet) {}
+
+    template <typename T>
+    bool on_assign(const T&, const T&) {
+        lastAssigned = Clock::now();
+        pending = true;
+        return false;
+    }
+
+    bool on_poll() {
+        if(!pending || Clock::now() - lastAssigned < quiet)
+            return false;
+        pending = false;
+        return true;
+    }
+};
@@ -1,20 +1,26 @@
 #pragma once
 #include <TDD/iobservable.h>
 #include <TDD/ilistener.h>
+#include <TDD/notify_policy.h>
 #include <set>
+#include <utility>
 
 
-template <typename T>
+/// NotifyPolicy (see notify_policy.h) decides which assignments reach the
+/// listeners; the default passes every assignment on.
+template <typename T, typename NotifyPolicy = notify_always>
 class observable : public iobservable<T> {
     T value;
     std::set<ilistener<T>*> listeners;
+    NotifyPolicy policy;
+    size_t suppressed = 0u;
 
     void registerListener_impl(ilistener<T>& l) override;
 
     void unregisterListener_impl(ilistener<T>& l) override;
     
 public:
-    explicit observable(T value);
+    explicit observable(T value, NotifyPolicy policy = NotifyPolicy{});
     
     observable(const observable& other);
 
@@ -28,48 +34,62 @@ public:
 
     observable& operator=(const T& val);
     
+    observable& operator=(T&& val);
+    
     operator const T& () const;
 
+    /// delivers the current value if the policy has held back a value that is due by now
+    bool poll();
+
+    /// number of assigned values the listeners have not been notified of
+    size_t suppressed_notifications() const;
+
+private:
+    void notify();
+    
+    void assigned(bool notifyNow);
+
 };
 
 
-template <typename T>
-void observable<T>::registerListener_impl(ilistener<T>& l) {
+template <typename T, typename NotifyPolicy>
+void observable<T,NotifyPolicy>::registerListener_impl(ilistener<T>& l) {
     listeners.insert(&l);
     l.add_raii(this,[this,&l]{ this->unregisterListener(l); });
 }
 
-template <typename T>
-void observable<T>::unregisterListener_impl(ilistener<T>& l) {
+template <typename T, typename NotifyPolicy>
+void observable<T,NotifyPolicy>::unregisterListener_impl(ilistener<T>& l) {
     listeners.erase(&l);
 }
 
-template <typename T>
-observable<T>::observable(T value)
-: value(value)
+template <typename T, typename NotifyPolicy>
+observable<T,NotifyPolicy>::observable(T value, NotifyPolicy policy)
+: value(std::move(value)), policy(std::move(policy))
 {
 }
 
-template <typename T>
-observable<T>::observable(const observable& other)
-: value(other.value), listeners(other.listeners)
+template <typename T, typename NotifyPolicy>
+observable<T,NotifyPolicy>::observable(const observable& other)
+: value(other.value), listeners(other.listeners), policy(other.policy), suppressed(other.suppressed)
 {
     for(auto& l : listeners)
         l->add_raii(this,[this,&l]{ this->unregisterListener(*l); });
 }
 
-template <typename T>
-observable<T>::observable(observable&& other)
-: value(std::move(other.value)), listeners(std::move(other.listeners))
+template <typename T, typename NotifyPolicy>
+observable<T,NotifyPolicy>::observable(observable&& other)
+: value(std::move(other.value)), listeners(std::move(other.listeners)), policy(std::move(other.policy)), suppressed(other.suppressed)
 {
+    other.suppressed = 0u;
     for(auto& l : listeners) {
         l->remove_raii(&other);
         l->add_raii(this,[this,&l]{ this->unregisterListener(*l); });
     }
 }
 
-template <typename T>
-observable<T>& observable<T>::operator = (const observable& other) {
+template <typename T, typename NotifyPolicy>
+observable<T,NotifyPolicy>& observable<T,NotifyPolicy>::operator = (const observable& other) {
     if(this != &other) {
         observable copy(other);
         *this = std::move(copy);
@@ -77,10 +97,13 @@ observable<T>& observable<T>::operator = (const observable& other) {
     return *this;
 }
 
-template <typename T>
-observable<T>& observable<T>::operator = (observable&& other) {
+template <typename T, typename NotifyPolicy>
+observable<T,NotifyPolicy>& observable<T,NotifyPolicy>::operator = (observable&& other) {
     listeners = std::move(other.listeners);
-    value = std::move(value);
+    value = std::move(other.value);
+    policy = std::move(other.policy);
+    suppressed = other.suppressed;
+    other.suppressed = 0u;
     for(auto& l : listeners) {
         l->remove_raii(&other);
         l->add_raii(this,[this,&l]{ this->unregisterListener(*l); });
@@ -88,21 +111,61 @@ observable<T>& observable<T>::operator = (observable&& other) {
     return *this;
 }
 
-template <typename T>
-observable<T>::~observable() {
+template <typename T, typename NotifyPolicy>
+observable<T,NotifyPolicy>::~observable() {
     for(auto& l : listeners)
         l->remove_raii(this);
 }
 
-template <typename T>
-observable<T>& observable<T>::operator=(const T& val) {
+template <typename T, typename NotifyPolicy>
+observable<T,NotifyPolicy>& observable<T,NotifyPolicy>::operator=(const T& val) {
+    const bool notifyNow = policy.on_assign(static_cast<const T&>(value), val);
     value = val;
-    for(auto& lstnr : listeners)
-        lstnr->handle(T(val));
+    assigned(notifyNow);
+    return *this;
+}
+
+template <typename T, typename NotifyPolicy>
+observable<T,NotifyPolicy>& observable<T,NotifyPolicy>::operator=(T&& val) {
+    const bool notifyNow = policy.on_assign(static_cast<const T&>(value), static_cast<const T&>(val));
+    value = std::move(val);
+    assigned(notifyNow);
     return *this;
 }
 
-template <typename T>
-observable<T>::operator const T& () const {
+template <typename T, typename NotifyPolicy>
+void observable<T,NotifyPolicy>::assigned(bool notifyNow) {
+    if(notifyNow)
+        notify();
+    else
+        ++suppressed;
+}
+
+/// all listeners share the stored value; only those that take ownership copy it
+template <typename T, typename NotifyPolicy>
+void observable<T,NotifyPolicy>::notify() {
+    const T& val = value;
+    for(auto& lstnr : listeners)
+        lstnr->handle(val);
+}
+
+template <typename T, typename NotifyPolicy>
+observable<T,NotifyPolicy>::operator const T& () const {
     return value;
 }
+
+template <typename T, typename NotifyPolicy>
+bool observable<T,NotifyPolicy>::poll() {
+    if(!policy.on_poll())
+        return false;
+    // a moved-from policy may still hold a value as due
+    if(suppressed != 0u)
+        --suppressed;
+    notify();
+    return true;
+}
+
+template <typename T, typename NotifyPolicy>
+size_t observable<T,NotifyPolicy>::suppressed_notifications() const {
+    return suppressed;
+}
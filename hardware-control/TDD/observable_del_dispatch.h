@@ -0,0 +1,112 @@
+#pragma once
+#include <TDD/iobservable.h>
+#include <TDD/ilistener.h>
+#include <TDD/ischeduler.h>
+#include <memory>
+#include <mutex>
+#include <set>
+
+/// Observable that hands notifications to a scheduler instead of calling the
+/// listeners in the assigning thread. An assignment copies the value once into
+/// a snapshot shared by the tasks of all listeners.
+///
+/// Lifetime: pending tasks only refer to the listener and the snapshot, so the
+/// observable may go away before they run. A listener that is unregistered or
+/// destroyed is unscheduled, which drops its pending tasks and waits for one
+/// that is running. listener<T> does so before its callable is destroyed;
+/// other listeners with state of their own have to unregister in their
+/// destructor, since the ilistener base only runs after the derived part is
+/// gone. Listeners may be registered, unregistered and destroyed on other
+/// threads than the one assigning. The scheduler must outlive the observable
+/// and its listeners.
+template <typename T> class
+observable_del_dispatch : public iobservable<T> {
+    std::mutex mutex;   ///< guards listeners; never held while waiting for a task
+    std::set<ilistener<T>*> listeners;
+    ischeduler<ilistener<T>*>* const scheduler;
+
+    void registerListener_impl(ilistener<T>& l) override;
+
+    void unregisterListener_impl(ilistener<T>& l) override;
+    
+    template <typename Make>
+    void dispatch(Make make_snapshot);
+    
+public:
+    observable_del_dispatch(ischeduler<ilistener<T>*>& s);
+    
+    observable_del_dispatch(const observable_del_dispatch&) = delete;
+    
+    ~observable_del_dispatch();
+    
+    observable_del_dispatch& operator = (const T& val);
+    
+    observable_del_dispatch& operator = (T&& val);
+};
+
+
+template <typename T>
+observable_del_dispatch<T>::observable_del_dispatch(ischeduler<ilistener<T>*>& s)
+    : scheduler(&s)
+{
+}
+
+template <typename T>
+observable_del_dispatch<T>::~observable_del_dispatch() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for(auto& l : listeners)
+        l->remove_raii(this);
+}
+
+template <typename T>
+void observable_del_dispatch<T>::registerListener_impl(ilistener<T>& l) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        listeners.insert(&l);
+    }
+    l.add_raii(this,[this,&l]{
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            listeners.erase(&l);
+        }
+        scheduler->unschedule(&l);
+    });
+}
+
+template <typename T>
+void observable_del_dispatch<T>::unregisterListener_impl(ilistener<T>& l) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(!listeners.erase(&l))
+            return;
+    }
+    l.remove_raii(this);
+    scheduler->unschedule(&l);
+}
+
+/// tasks are scheduled under the lock, so a listener erased afterwards has
+/// them dropped by its unschedule; without listeners nothing is copied
+template <typename T>
+template <typename Make>
+void observable_del_dispatch<T>::dispatch(Make make_snapshot) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if(listeners.empty())
+        return;
+    const std::shared_ptr<const T> snapshot = make_snapshot();
+    for(auto& lstnr : listeners)
+        scheduler->schedule(lstnr,[snapshot,lstnr]{
+            lstnr->handle(*snapshot);
+        });
+}
+
+template <typename T>
+observable_del_dispatch<T>& observable_del_dispatch<T>::operator = (const T& val) {
+    dispatch([&val]{ return std::make_shared<const T>(val); });
+    return *this;
+}
+
+template <typename T>
+observable_del_dispatch<T>& observable_del_dispatch<T>::operator = (T&& val) {
+    dispatch([&val]{ return std::make_shared<const T>(std::move(val)); });
+    return *this;
+}
@@ -1,148 +1,16 @@
-//
-//  test_observer.cpp
-//  hardware-control
-//
-//  Created by Julian Becker on 03.09.15.
-//  Copyright (c) 2015 Julian Becker. All rights reserved.
-//
-#include "../catch.h"
-#include <stdio.h>
+#include <TDD/observable_del_dispatch.h>
+#include <TDD/worker_scheduler.h>
+#include <TDD/listener.h>
+#include <catch.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
 #include <memory>
-#include <list>
-#include <string>
-#include <sstream>
-#include <map>
 #include <queue>
+#include <thread>
 #include <tuple>
-#include <functional>
-#include <TDD/inotifyable.h>
-#include <TDD/with_destructor.h>
-#include <TDD/iobservable.h>
-#include <TDD/ilistener.h>
-#include <TDD/observable.h>
-
-
-
-template <typename T> class
-dependent_value {
-   
-    struct holder {
-        virtual ~holder() {}
-        virtual const T& get_value() const = 0;
-    };
-    
-    template <typename T1> struct
-    concrete final : holder, ilistener<T1> {
-        T val;
-        std::function<T(T1)> behavior;
-
-        const T& get_value() const override {
-            return val;
-        }
-        
-        concrete(observable<T1>& o, std::function<T(T1)> fun)
-        : val(fun(static_cast<const T1&>(o))),
-          behavior(std::move(fun))
-        {
-            o.registerListener(*this);
-        }
-        
-    private:
-        void handle_impl(T1&& valIn) override {
-            val = behavior(std::move(valIn));
-        }
-    };
-    
-    std::shared_ptr<holder> impl;
-    
-public:
-    template <typename T1, typename Callable>
-    dependent_value(observable<T1>& obsIn, Callable fun)
-        : impl(new concrete<T1>{obsIn,fun})
-    {
-    }
-    
-    operator const T& () const {
-        return impl->get_value();
-    }
-};
-
-TEST_CASE("dependent_value","[dependent_value]") {
-    observable<int> obs(1);
-    dependent_value<std::string> value(obs,[](int&& i){
-        return (std::stringstream() << i).str();
-    });
-    
-    WHEN("the value of the dependent value is retrieved") {
-        THEN("the retrieved value it is equal to the behavior applied to the initial value of the observable") {
-            REQUIRE(std::string("1") == static_cast<const std::string&>(value));
-        }
-    }
-    
-    AND_WHEN("assigning the observable a value") {
-        obs = 7;
-        THEN("the dependent value will be updated") {
-            REQUIRE(std::string("7") == static_cast<const std::string&>(value));
-        }
-    }
-}
-
-template <typename TaskId> struct
-ischeduler : with_destructor<TaskId> {
-    template <typename Callable>
-    void schedule(TaskId task_id, Callable&& fun) {
-        schedule_impl(std::move(task_id), std::forward<Callable>(fun));
-    }
-
-    void unschedule(TaskId task_id) {
-        unschedule_impl(std::move(task_id));
-    }
-    
-private:
-    virtual void schedule_impl(TaskId task_id, std::function<void()> f) = 0;
-    virtual void unschedule_impl(TaskId task_id) = 0;
-};
-
-template <typename T> class
-observable_del_dispatch : public iobservable<T> {
-    std::set<ilistener<T>*> listeners;
-    ischeduler<ilistener<T>*>* const scheduler;
-
-    void registerListener_impl(ilistener<T>& l) override {
-        listeners.insert(&l);
-        l.add_raii(this,[this,&l]{
-            this->unregisterListener(l);
-            scheduler->unschedule(&l);
-        });
-    }
-
-    void unregisterListener_impl(ilistener<T>& l) override {
-        listeners.erase(&l);
-    }
-    
-public:
-    observable_del_dispatch(ischeduler<ilistener<T>*>& s)
-        : scheduler(&s)
-    {
-        INFO("observable_del_dispatch: constructor");
-    }
-    
-    ~observable_del_dispatch() {
-        INFO("observable_del_dispatch: destructor");
-        for(auto& l : listeners) {
-            l->remove_raii(this);
-        }
-    }
-    
-    
-    observable_del_dispatch& operator = (const T& val) {
-        for(auto& lstnr : listeners)
-            scheduler->schedule(lstnr,[val,lstnr]{
-                lstnr->handle(T(val));
-            });
-        return *this;
-    }
-};
+#include <vector>
 
 TEST_CASE("observable with delegated dispatch","[observable_del_dispatch]") {
     struct test_scheduler : ischeduler<ilistener<int>*> {
@@ -276,3 +144,142 @@ TEST_CASE("observable_del_dispatch task lifetime","[observable_del_dispatch]") {
         }
     }
 }
+
+SCENARIO("observable_del_dispatch on a worker_scheduler","[observable_del_dispatch]") {
+    worker_scheduler<ilistener<int>*> scheduler;
+    
+    GIVEN("an observable with two listeners") {
+        observable_del_dispatch<int> obs(scheduler);
+        std::mutex mutex;
+        std::vector<int> seen1, seen2;
+        std::thread::id handledOn;
+        listener<int> l1([&](int&& v){
+            std::lock_guard<std::mutex> lock(mutex);
+            handledOn = std::this_thread::get_id();
+            seen1.push_back(v);
+        });
+        listener<int> l2([&](int&& v){
+            std::lock_guard<std::mutex> lock(mutex);
+            seen2.push_back(v);
+        });
+        obs.registerListener(l1);
+        obs.registerListener(l2);
+        
+        WHEN("a sequence of values is assigned") {
+            for(int i = 0; i < 100; ++i)
+                obs = i;
+            std::promise<void> drained;
+            scheduler.schedule(nullptr,[&]{ drained.set_value(); });
+            drained.get_future().wait();
+            THEN("each listener receives the values in order, off the assigning thread") {
+                std::lock_guard<std::mutex> lock(mutex);
+                REQUIRE(handledOn != std::this_thread::get_id());
+                REQUIRE(100u == seen1.size());
+                REQUIRE(100u == seen2.size());
+                for(size_t i = 1; i < seen1.size(); ++i)
+                    REQUIRE(seen1[i-1] < seen1[i]);
+                for(size_t i = 1; i < seen2.size(); ++i)
+                    REQUIRE(seen2[i-1] < seen2[i]);
+            }
+        }
+    }
+    
+    GIVEN("a listener that is slow to handle a value") {
+        auto obs = std::make_shared<observable_del_dispatch<int>>(scheduler);
+        std::atomic<int> handled(0);
+        std::atomic<bool> started(false);
+        auto l = std::make_shared<listener<int>>([&](int&&){
+            started = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            ++handled;
+        });
+        obs->registerListener(*l);
+        
+        WHEN("values are pending and the listener unregisters while one is handled") {
+            *obs = 1;
+            *obs = 2;
+            *obs = 3;
+            while(!started)
+                std::this_thread::yield();
+            obs->unregisterListener(*l);
+            THEN("the running notification has completed and the pending ones are dropped") {
+                REQUIRE(1 == handled);
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                REQUIRE(1 == handled);
+            }
+        }
+        
+        WHEN("the observable is destroyed while notifications are pending") {
+            *obs = 1;
+            obs = nullptr;
+            THEN("the pending notification is still delivered") {
+                while(handled == 0)
+                    std::this_thread::yield();
+                REQUIRE(1 == handled);
+            }
+        }
+    }
+    
+    GIVEN("a listener whose callable holds state, handling a value") {
+        observable_del_dispatch<int> obs(scheduler);
+        std::atomic<bool> running(false);
+        std::atomic<size_t> destroyedWhileRunning(0u);
+        struct state {
+            std::atomic<bool>* running;
+            std::atomic<size_t>* destroyedWhileRunning;
+            ~state() {
+                if(*running)
+                    ++*destroyedWhileRunning;
+            }
+        };
+        auto s = std::make_shared<state>(state{ &running, &destroyedWhileRunning });
+        std::unique_ptr<listener<int>> l(new listener<int>([s](int&&){
+            *s->running = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            *s->running = false;
+        }));
+        s = nullptr;
+        obs.registerListener(*l);
+        
+        WHEN("the listener is destroyed without unregistering") {
+            obs = 1;
+            obs = 2;
+            while(!running)
+                std::this_thread::yield();
+            l = nullptr;
+            THEN("the running notification completes before the callable is destroyed") {
+                REQUIRE(0u == destroyedWhileRunning);
+                REQUIRE(!running);
+            }
+        }
+    }
+    
+    GIVEN("listeners that come and go on another thread while values are assigned") {
+        observable_del_dispatch<int> obs(scheduler);
+        std::atomic<bool> done(false);
+        std::atomic<size_t> handled(0u);
+        std::thread churn([&]{
+            for(int i = 0; i < 200; ++i) {
+                listener<int> l([&handled](int&&){ ++handled; });
+                obs.registerListener(l);
+                std::this_thread::yield();
+                if(i % 2)
+                    obs.unregisterListener(l);
+            }
+            done = true;
+        });
+        
+        WHEN("the assigning thread keeps dispatching") {
+            int assigned = 0;
+            while(!done)
+                obs = ++assigned;
+            churn.join();
+            THEN("no notification reaches a listener that is gone") {
+                std::promise<void> drained;
+                scheduler.schedule(nullptr,[&]{ drained.set_value(); });
+                drained.get_future().wait();
+                REQUIRE(handled <= static_cast<size_t>(assigned));
+            }
+        }
+    }
+}
@@ -7,7 +7,9 @@
 //
 
 #include <TDD/observable.h>
+#include <TDD/listener.h>
 #include <catch.h>
+#include <vector>
 
 
 struct test_listener final : ilistener<int> {
@@ -251,3 +253,258 @@ TEST_CASE("moving an observable into another observable keeps the listeners inta
 
 
 
+
+namespace {
+
+struct copy_counting {
+    static size_t copies;
+    int payload = 0;
+    copy_counting() = default;
+    copy_counting(int payload) : payload(payload) {}
+    copy_counting(const copy_counting& other) : payload(other.payload) { ++copies; }
+    copy_counting(copy_counting&& other) = default;
+    copy_counting& operator=(const copy_counting& other) { payload = other.payload; ++copies; return *this; }
+    copy_counting& operator=(copy_counting&& other) = default;
+};
+
+size_t copy_counting::copies = 0u;
+
+struct reading_listener final : ilistener<copy_counting> {
+    int payload = 0;
+private:
+    void handle_impl(copy_counting&& val) override {
+        payload = val.payload;
+    }
+    void handle_impl(const copy_counting& val) override {
+        payload = val.payload;
+    }
+};
+
+struct owning_listener final : ilistener<copy_counting> {
+    copy_counting value;
+private:
+    void handle_impl(copy_counting&& val) override {
+        value = std::move(val);
+    }
+};
+
+}
+
+
+TEST_CASE("Notification shares the assigned value between listeners", "[observable]") {
+    observable<copy_counting> obs(copy_counting{0});
+    reading_listener reader1, reader2, reader3;
+    owning_listener owner;
+    obs.registerListener(reader1);
+    obs.registerListener(reader2);
+    obs.registerListener(reader3);
+    
+    WHEN("a value is move-assigned and only reading listeners are registered") {
+        copy_counting::copies = 0u;
+        obs = copy_counting{42};
+        THEN("the value is not copied at all") {
+            REQUIRE(copy_counting::copies == 0u);
+            REQUIRE(reader1.payload == 42);
+            REQUIRE(reader3.payload == 42);
+        }
+    }
+    
+    WHEN("a value is copy-assigned and a listener wants ownership") {
+        obs.registerListener(owner);
+        const copy_counting val{7};
+        copy_counting::copies = 0u;
+        obs = val;
+        THEN("only the stored value and the owning listener's value are copies") {
+            REQUIRE(copy_counting::copies == 2u);
+            REQUIRE(owner.value.payload == 7);
+            REQUIRE(reader2.payload == 7);
+        }
+    }
+}
+
+
+TEST_CASE("A listener with a by-value callable", "[observable][listener]") {
+    int last = 0, calls = 0;
+    listener<copy_counting> l([&last, &calls](copy_counting val) { last = val.payload; ++calls; });
+    
+    WHEN("it is handed a value to move from") {
+        copy_counting::copies = 0u;
+        l.handle(copy_counting{3});
+        THEN("the value is moved into the parameter") {
+            REQUIRE(copy_counting::copies == 0u);
+            REQUIRE(last == 3);
+        }
+    }
+    
+    WHEN("it is notified by an observable") {
+        observable<copy_counting> obs(copy_counting{0});
+        obs.registerListener(l);
+        copy_counting::copies = 0u;
+        obs = copy_counting{5};
+        THEN("only the parameter is a copy") {
+            REQUIRE(copy_counting::copies == 1u);
+            REQUIRE(last == 5);
+        }
+    }
+}
+
+
+TEST_CASE("A listener with a stateful callable keeps one state on both paths", "[listener]") {
+    std::vector<int> counts;
+    listener<int> l([n = 0, &counts](const int&) mutable { counts.push_back(++n); });
+    const int shared = 1;
+    l.handle(2);
+    l.handle(shared);
+    l.handle(3);
+    REQUIRE(counts == std::vector<int>({1, 2, 3}));
+}
+
+
+namespace {
+
+struct manual_clock {
+    using duration = std::chrono::milliseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<manual_clock>;
+    static constexpr bool is_steady = true;
+    
+    static time_point current;
+    static time_point now() { return current; }
+    static void advance(duration d) { current += d; }
+};
+
+manual_clock::time_point manual_clock::current{};
+
+}
+
+
+TEST_CASE("An observable suppressing unchanged values", "[observable][notify_policy]") {
+    observable<int, notify_on_change<>> obs(0);
+    test_listener lstnr;
+    obs.registerListener(lstnr);
+    
+    obs = 1;
+    obs = 1;
+    obs = 2;
+    obs = 2;
+    obs = 2;
+    REQUIRE(lstnr.triggered == 2u);
+    REQUIRE(obs.suppressed_notifications() == 3u);
+    REQUIRE(2 == obs);
+}
+
+
+TEST_CASE("A throttled observable", "[observable][notify_policy]") {
+    observable<int, throttle<manual_clock>> obs(0, throttle<manual_clock>(std::chrono::milliseconds(50)));
+    test_listener lstnr;
+    obs.registerListener(lstnr);
+    
+    WHEN("values are assigned faster than the interval") {
+        for(int i = 1; i <= 10; ++i) {
+            obs = i;
+            manual_clock::advance(std::chrono::milliseconds(1));
+        }
+        THEN("only the first one is passed on right away") {
+            REQUIRE(lstnr.triggered == 1u);
+            REQUIRE(lstnr.value == 1);
+            REQUIRE(obs.suppressed_notifications() == 9u);
+        }
+        AND_THEN("the latest value is delivered by poll() once the interval has passed") {
+            REQUIRE(!obs.poll());
+            manual_clock::advance(std::chrono::milliseconds(50));
+            REQUIRE(obs.poll());
+            REQUIRE(lstnr.triggered == 2u);
+            REQUIRE(lstnr.value == 10);
+            REQUIRE(obs.suppressed_notifications() == 8u);
+            REQUIRE(!obs.poll());
+        }
+    }
+    
+    WHEN("values are assigned slower than the interval") {
+        obs = 1;
+        manual_clock::advance(std::chrono::milliseconds(50));
+        obs = 2;
+        THEN("every value is passed on") {
+            REQUIRE(lstnr.triggered == 2u);
+            REQUIRE(obs.suppressed_notifications() == 0u);
+        }
+    }
+}
+
+
+TEST_CASE("A debounced observable", "[observable][notify_policy]") {
+    observable<int, debounce<manual_clock>> obs(0, debounce<manual_clock>(std::chrono::milliseconds(20)));
+    test_listener lstnr;
+    obs.registerListener(lstnr);
+    
+    for(int i = 1; i <= 5; ++i) {
+        obs = i;
+        manual_clock::advance(std::chrono::milliseconds(10));
+        REQUIRE(!obs.poll());
+    }
+    REQUIRE(lstnr.triggered == 0u);
+    
+    manual_clock::advance(std::chrono::milliseconds(10));
+    REQUIRE(obs.poll());
+    REQUIRE(lstnr.triggered == 1u);
+    REQUIRE(lstnr.value == 5);
+    REQUIRE(obs.suppressed_notifications() == 4u);
+}
+
+
+TEST_CASE("Change suppression combined with throttling", "[observable][notify_policy]") {
+    observable<int, notify_on_change<throttle<manual_clock>>> obs(0, throttle<manual_clock>(std::chrono::milliseconds(50)));
+    test_listener lstnr;
+    obs.registerListener(lstnr);
+    
+    obs = 0;
+    REQUIRE(lstnr.triggered == 0u);
+    obs = 1;
+    REQUIRE(lstnr.triggered == 1u);
+    obs = 2;
+    REQUIRE(lstnr.triggered == 1u);
+    manual_clock::advance(std::chrono::milliseconds(50));
+    REQUIRE(obs.poll());
+    REQUIRE(lstnr.value == 2);
+}
+
+
+TEST_CASE("Copies and moves of a throttled observable keep the suppressed count", "[observable][notify_policy]") {
+    observable<int, throttle<manual_clock>> obs(0, throttle<manual_clock>(std::chrono::milliseconds(50)));
+    obs = 1;
+    obs = 2;
+    obs = 3;
+    REQUIRE(obs.suppressed_notifications() == 2u);
+    manual_clock::advance(std::chrono::milliseconds(50));
+    
+    WHEN("it is copied") {
+        auto copy = obs;
+        THEN("poll() on the copy counts down from the original's count") {
+            REQUIRE(copy.suppressed_notifications() == 2u);
+            REQUIRE(copy.poll());
+            REQUIRE(copy.suppressed_notifications() == 1u);
+        }
+    }
+    
+    WHEN("it is moved") {
+        auto moved = std::move(obs);
+        THEN("the count moves along and the source is left at zero") {
+            REQUIRE(moved.suppressed_notifications() == 2u);
+            REQUIRE(obs.suppressed_notifications() == 0u);
+            REQUIRE(moved.poll());
+            REQUIRE(moved.suppressed_notifications() == 1u);
+            obs.poll();
+            REQUIRE(obs.suppressed_notifications() == 0u);
+        }
+    }
+    
+    WHEN("it is move-assigned") {
+        observable<int, throttle<manual_clock>> target(0, throttle<manual_clock>(std::chrono::milliseconds(50)));
+        target = std::move(obs);
+        THEN("poll() does not wrap the count") {
+            REQUIRE(target.poll());
+            REQUIRE(target.suppressed_notifications() == 1u);
+        }
+    }
+}
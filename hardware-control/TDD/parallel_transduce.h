@@ -0,0 +1,92 @@
+#pragma once
+#include <TDD/transducers.h>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <iterator>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/// Parallel reduction for associative step functions over random access
+/// ranges. The input is cut into chunks of chunk_size elements; each chunk
+/// is reduced from init on one of the worker threads and the partial
+/// states are combined in input order:
+///
+///     combine(combine(s0, s1), s2) ...
+///
+/// init has to be neutral for combine, e.g. 0 for a sum. As the chunks only
+/// depend on chunk_size, the result is the same for any number of threads,
+/// floating point sums included. Every chunk runs its own copy of the
+/// transducers, so only stateless ones (map, filter) give the sequential
+/// result; take, partition, window and the like see chunk boundaries.
+
+namespace transducers {
+
+    struct parallel_options {
+        size_t chunk_size = 1u << 14;
+        /// 0 uses one thread per core
+        size_t threads = 0u;
+    };
+
+    template <typename Make, typename Step, typename Combine, typename State, typename Range>
+    State parallel_transduce(const xform<Make>& xf, Step step, Combine combine, State init, Range&& input, parallel_options options = {}) {
+        const auto first = std::begin(input);
+        using iterator = std::decay_t<decltype(first)>;
+        static_assert(std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<iterator>::iterator_category>::value,
+                      "parallel reduction needs a random access range");
+
+        const size_t n = static_cast<size_t>(std::distance(first, std::end(input)));
+        const size_t chunk = std::max<size_t>(options.chunk_size, 1u);
+        const size_t count = (n + chunk - 1u) / chunk;
+        if(count == 0u)
+            return init;
+
+        std::vector<State> partial(count, init);
+        std::atomic<size_t> next(0u);
+        auto work = [&] {
+            for(size_t c = next++; c < count; c = next++) {
+                auto rf = xf(completing<Step>{ step });
+                State state = std::move(partial[c]);
+                const iterator last = first + static_cast<std::ptrdiff_t>(std::min(n, (c + 1u) * chunk));
+                for(iterator it = first + static_cast<std::ptrdiff_t>(c * chunk); it != last && !rf.done(); ++it)
+                    state = rf(std::move(state), *it);
+                partial[c] = rf.complete(std::move(state));
+            }
+        };
+
+        const size_t cores = std::max<size_t>(std::thread::hardware_concurrency(), 1u);
+        const size_t threads = std::min(options.threads != 0u ? options.threads : cores, count);
+        std::vector<std::exception_ptr> errors(threads);
+        auto guarded = [&](size_t t) {
+            try {
+                work();
+            } catch(...) {
+                errors[t] = std::current_exception();
+                next = count;
+            }
+        };
+        std::vector<std::thread> workers;
+        workers.reserve(threads - 1u);
+        for(size_t t = 1u; t < threads; ++t)
+            workers.emplace_back(guarded, t);
+        guarded(0u);
+        for(auto& worker : workers)
+            worker.join();
+        for(auto& error : errors)
+            if(error)
+                std::rethrow_exception(error);
+
+        State result = std::move(partial[0]);
+        for(size_t c = 1u; c < count; ++c)
+            result = combine(std::move(result), std::move(partial[c]));
+        return result;
+    }
+
+    template <typename Step, typename Combine, typename State, typename Range>
+    State parallel_reduce(Step step, Combine combine, State init, Range&& input, parallel_options options = {}) {
+        const auto identity = make_xform([](auto rf) { return rf; });
+        return parallel_transduce(identity, std::move(step), std::move(combine), std::move(init), std::forward<Range>(input), options);
+    }
+
+}
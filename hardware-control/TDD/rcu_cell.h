@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/// Holds a std::shared_ptr<const T> that many threads read while few replace
+/// it. load() is lock-free: a reader enters the current epoch by
+/// incrementing one of two counters, copies the shared_ptr and leaves again,
+/// so it never waits for a writer. store() swaps the pointer and then waits
+/// for a grace period: it flips the epoch twice and each time waits until
+/// the readers counted in the old epoch have left, after which no reader can
+/// still be copying the replaced shared_ptr. Writers wait for each other and
+/// for readers, but only for as long as a reader needs to copy a shared_ptr.
+/// update() computes the replacement from the pointer it replaces, so
+/// concurrent updates see each other's results.
+template <typename T> class
+rcu_cell {
+    using pointer = std::shared_ptr<const T>;
+
+    std::atomic<pointer*> current;
+    std::atomic<unsigned> epoch{0u};
+    mutable std::atomic<size_t> readers[2];
+    std::mutex writing;
+
+    void synchronize();
+
+public:
+    explicit rcu_cell(pointer initial);
+
+    rcu_cell(const rcu_cell&) = delete;
+
+    rcu_cell& operator = (const rcu_cell&) = delete;
+
+    ~rcu_cell();
+
+    pointer load() const;
+
+    void store(pointer p);
+
+    template <typename Make>
+    void update(Make make);
+};
+
+
+template <typename T>
+rcu_cell<T>::rcu_cell(pointer initial)
+: current(new pointer(std::move(initial)))
+{
+    readers[0] = 0u;
+    readers[1] = 0u;
+}
+
+template <typename T>
+rcu_cell<T>::~rcu_cell() {
+    delete current.load();
+}
+
+template <typename T>
+typename rcu_cell<T>::pointer rcu_cell<T>::load() const {
+    auto& counter = readers[epoch.load() & 1u];
+    ++counter;
+    pointer p = *current.load();
+    --counter;
+    return p;
+}
+
+template <typename T>
+void rcu_cell<T>::store(pointer p) {
+    update([&p](const pointer&) { return std::move(p); });
+}
+
+/// the replaced pointer is released after the lock, in case it was the last reference
+template <typename T>
+template <typename Make>
+void rcu_cell<T>::update(Make make) {
+    std::unique_ptr<pointer> replaced;
+    std::lock_guard<std::mutex> lock(writing);
+    auto replacement = new pointer(make(*current.load()));
+    replaced.reset(current.exchange(replacement));
+    synchronize();
+}
+
+template <typename T>
+void rcu_cell<T>::synchronize() {
+    for(int flip = 0; flip < 2; ++flip) {
+        const unsigned old = epoch.fetch_add(1u);
+        while(readers[old & 1u].load() != 0u)
+            std::this_thread::yield();
+    }
+}
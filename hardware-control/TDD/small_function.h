@@ -0,0 +1,124 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template <typename Signature, size_t Capacity = 2*sizeof(void*)> class
+small_function;
+
+/// Copyable function wrapper like std::function that stores callables of up
+/// to Capacity bytes in place; larger ones go to the heap. The default
+/// capacity holds a closure capturing two pointers, e.g. [this,&l].
+template <typename R, typename...Args, size_t Capacity> class
+small_function<R(Args...),Capacity> {
+    static_assert(Capacity >= sizeof(void*), "small_function needs room for a pointer to a heap callable");
+    
+    struct ops {
+        R (*invoke)(void* f, Args&&...args);
+        void (*move)(void* from, void* to);
+        void (*copy)(const void* from, void* to);
+        void (*destroy)(void* f);
+    };
+    
+    template <typename F> struct
+    inline_ops {
+        static R invoke(void* f, Args&&...args) { return (*static_cast<F*>(f))(std::forward<Args>(args)...); }
+        static void move(void* from, void* to) { new(to) F(std::move(*static_cast<F*>(from))); static_cast<F*>(from)->~F(); }
+        static void copy(const void* from, void* to) { new(to) F(*static_cast<const F*>(from)); }
+        static void destroy(void* f) { static_cast<F*>(f)->~F(); }
+        static const ops table;
+    };
+    
+    template <typename F> struct
+    heap_ops {
+        static F*& get(void* f) { return *static_cast<F**>(f); }
+        static R invoke(void* f, Args&&...args) { return (*get(f))(std::forward<Args>(args)...); }
+        static void move(void* from, void* to) { new(to) F*(get(from)); }
+        static void copy(const void* from, void* to) { new(to) F*(new F(**static_cast<F* const*>(from))); }
+        static void destroy(void* f) { delete get(f); }
+        static const ops table;
+    };
+    
+    template <typename F> using
+    fits = std::integral_constant<bool,
+        sizeof(F) <= Capacity &&
+        alignof(F) <= alignof(void*) &&
+        std::is_nothrow_move_constructible<F>::value>;
+    
+    alignas(void*) unsigned char storage[Capacity];
+    const ops* vtable = nullptr;
+    
+    template <typename F>
+    void emplace(F&& f, std::true_type) {
+        new(storage) std::decay_t<F>(std::forward<F>(f));
+        vtable = &inline_ops<std::decay_t<F>>::table;
+    }
+    
+    template <typename F>
+    void emplace(F&& f, std::false_type) {
+        new(storage) std::decay_t<F>*(new std::decay_t<F>(std::forward<F>(f)));
+        vtable = &heap_ops<std::decay_t<F>>::table;
+    }
+    
+public:
+    small_function() = default;
+    
+    template <typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>,small_function>::value>>
+    small_function(F&& f) {
+        emplace(std::forward<F>(f), fits<std::decay_t<F>>{});
+    }
+    
+    small_function(const small_function& other) {
+        if(other.vtable) {
+            other.vtable->copy(other.storage, storage);
+            vtable = other.vtable;
+        }
+    }
+    
+    small_function(small_function&& other) noexcept {
+        if(other.vtable) {
+            other.vtable->move(other.storage, storage);
+            vtable = other.vtable;
+            other.vtable = nullptr;
+        }
+    }
+    
+    small_function& operator = (small_function other) noexcept {
+        if(vtable)
+            vtable->destroy(storage);
+        vtable = other.vtable;
+        if(vtable)
+            vtable->move(other.storage, storage);
+        other.vtable = nullptr;
+        return *this;
+    }
+    
+    ~small_function() {
+        if(vtable)
+            vtable->destroy(storage);
+        vtable = nullptr;
+    }
+    
+    explicit operator bool() const { return vtable != nullptr; }
+    
+    R operator()(Args...args) const {
+        if(!vtable)
+            throw std::bad_function_call();
+        return vtable->invoke(const_cast<unsigned char*>(storage), std::forward<Args>(args)...);
+    }
+};
+
+
+template <typename R, typename...Args, size_t Capacity>
+template <typename F>
+const typename small_function<R(Args...),Capacity>::ops small_function<R(Args...),Capacity>::inline_ops<F>::table = {
+    &inline_ops<F>::invoke, &inline_ops<F>::move, &inline_ops<F>::copy, &inline_ops<F>::destroy
+};
+
+template <typename R, typename...Args, size_t Capacity>
+template <typename F>
+const typename small_function<R(Args...),Capacity>::ops small_function<R(Args...),Capacity>::heap_ops<F>::table = {
+    &heap_ops<F>::invoke, &heap_ops<F>::move, &heap_ops<F>::copy, &heap_ops<F>::destroy
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+/// Non-owning view of a contiguous sequence of elements.
+template <typename T> class
+span {
+    T* ptr = nullptr;
+    size_t count = 0u;
+
+public:
+    using element_type = T;
+    using value_type = std::remove_cv_t<T>;
+    using iterator = T*;
+
+    constexpr span() = default;
+
+    constexpr span(T* ptr, size_t count)
+        : ptr(ptr), count(count)
+    {}
+
+    constexpr span(T* first, T* last)
+        : ptr(first), count(static_cast<size_t>(last - first))
+    {}
+
+    template <typename Container, typename = decltype(std::declval<Container&>().data())>
+    span(Container& c)
+        : ptr(c.data()), count(c.size())
+    {}
+
+    template <typename U, typename = std::enable_if_t<std::is_convertible<U(*)[],T(*)[]>::value>>
+    constexpr span(const span<U>& other)
+        : ptr(other.data()), count(other.size())
+    {}
+
+    constexpr T* data() const { return ptr; }
+    constexpr size_t size() const { return count; }
+    constexpr bool empty() const { return count == 0u; }
+
+    constexpr T* begin() const { return ptr; }
+    constexpr T* end() const { return ptr + count; }
+
+    constexpr T& operator[] (size_t i) const { return ptr[i]; }
+
+    constexpr span first(size_t n) const { return { ptr, n }; }
+    constexpr span subspan(size_t offset, size_t n) const { return { ptr + offset, n }; }
+    constexpr span subspan(size_t offset) const { return { ptr + offset, count - offset }; }
+};
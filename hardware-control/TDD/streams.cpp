@@ -7,11 +7,18 @@
 //
 
 #include "streams.hpp"
+#include <TDD/mapped_file.h>
+#include <TDD/container_binary.h>
+#include <TDD/container_text.h>
+#include <TDD/container_patch.h>
 #include <catch.h>
 #include <iostream>
 #include <type_traits>
 #include <cxxabi.h>
 #include <string>
+#include <sstream>
+#include <numeric>
+#include <vector>
 namespace {
 
 std::string demangle(const char* name);
@@ -41,287 +48,179 @@ std::string demangle(const char* name) {
 
 
 
-template <typename Element> class
-stream {
-    using element_type = Element;
-};
-
-template <
-    typename Element,
-    typename Impl> class
-input_stream
-    : public stream <Element>
-{
-    using input_iterator = typename Impl::input_iterator;
-    input_iterator begin() { return begin_impl(); }
-private:
-    virtual input_iterator begin_impl() = 0;
-};
-
+TEST_CASE("running_integer ranges are iterated without indirection","[stream]") {
+    int sum = 0;
+    for(int i : running_integers(1, 101))
+        sum += i;
+    REQUIRE(5050 == sum);
+    
+    static_assert(std::is_trivially_copyable<running_integer>::value, "copying an iterator must not allocate");
+    static_assert(std::is_base_of<std::forward_iterator_tag, std::iterator_traits<running_integer>::iterator_category>::value, "copies count on independently");
+    auto it = running_integer(7);
+    auto copy = it++;
+    REQUIRE(7 == *copy);
+    REQUIRE(8 == *it);
+}
 
 
-template <
-    typename T,
-    typename IteratorState> class
-input_iterator {
-    using
-    iterator_state = IteratorState;
-    
-    using
-    value_type = T;
-    
-    virtual void
-    moveNext_impl() { return impl->moveNext_impl(); }
-    
-    virtual value_type&
-    access_impl  () { return impl->access_impl  (); }
-    
-    virtual input_iterator*
-    clone_impl   () { return impl->clone_impl   (); }
-    
-    virtual bool
-    compare_impl (const input_iterator& other) { return impl->compare_impl (other); }
-    
-    input_iterator* impl;
-    
-protected:
-    input_iterator()
-        : impl(this)
-    {}
-    
-public:
-    ~input_iterator()
-    {}
-    
-    input_iterator(const input_iterator& other)
-        : impl(other.impl->clone_impl())
-    {}
-    
-    input_iterator(input_iterator&& other)
-        : impl(std::move(other.impl))
-    {}
-    
-    input_iterator& operator= (const input_iterator& other) {
-        auto copy(other);
-        *this = std::move(copy);
-        return *this;
-    }
-    
-    input_iterator& operator= (input_iterator&& other) {
-        std::swap(impl, other.impl );
-        return *this;
-    }
-    
-    value_type& operator* () {
-        return impl->access_impl();
-    }
+TEST_CASE("chunks of a contiguous range are views into it","[stream]") {
+    std::vector<int> samples(1000);
+    std::iota(samples.begin(), samples.end(), 0);
     
-    value_type& operator* () const {
-        return impl->access_impl();
+    size_t count = 0u;
+    long sum = 0;
+    const int* expected = samples.data();
+    for(span<const int> chunk : chunks(samples, 64u)) {
+        REQUIRE(expected == chunk.data());
+        REQUIRE(chunk.size() <= 64u);
+        expected += chunk.size();
+        ++count;
+        sum = std::accumulate(chunk.begin(), chunk.end(), sum);
     }
-    
-    value_type* operator-> () {
-        return &impl->access_impl();
-    }
-    
-    input_iterator& operator++() {
-        impl->moveNext_impl();
-        return *this;
-    }
-    
-    input_iterator operator++(int) {
-        auto copy(*this);
-        operator++();
-        return copy;
-    }
-    
-    friend bool operator == (const input_iterator& a, const input_iterator& b) {
-        return a.impl->compare_impl(b);
-    }
-    
-    friend bool operator != (const input_iterator& a, const input_iterator& b) {
-        return !a.impl->compare_impl(b);
+    REQUIRE(16u == count);
+    REQUIRE(999L * 1000L / 2L == sum);
+}
+
+
+TEST_CASE("chunks of other ranges are filled from their elements","[stream]") {
+    std::vector<size_t> sizes;
+    long sum = 0;
+    for(span<const int> chunk : chunks(running_integers(0, 100), 30u)) {
+        sizes.push_back(chunk.size());
+        sum = std::accumulate(chunk.begin(), chunk.end(), sum);
     }
-};
+    REQUIRE((std::vector<size_t>{30u, 30u, 30u, 10u}) == sizes);
+    REQUIRE(4950L == sum);
+}
 
 
-class
-running_integer final
-    : public input_iterator<int, int*>
-{
-    using base_type = input_iterator<int, int*>;
-    using value_type = int;
-    using iterator_state = int*;
+TEST_CASE("input_stream erases the type of a range","[stream]") {
+    input_stream<int> numbers = running_integers(0, 1000);
     
-    void
-    moveNext_impl() override {
-        value++;
+    WHEN("it is iterated element by element") {
+        long sum = 0;
+        for(int i : numbers)
+            sum += i;
+        THEN("all elements are visited") {
+            REQUIRE(499500L == sum);
+        }
     }
     
-    value_type&
-    access_impl  () override {
-        return value;
+    WHEN("it is read in blocks") {
+        std::vector<int> block(300);
+        std::vector<size_t> sizes;
+        while(size_t n = numbers.read(block.data(), block.size()))
+            sizes.push_back(n);
+        THEN("the blocks cover the stream") {
+            REQUIRE((std::vector<size_t>{300u, 300u, 300u, 100u}) == sizes);
+        }
     }
     
-    input_iterator*
-    clone_impl   () override {
-        return new running_integer(value);
+    WHEN("it is copied after reading part of it") {
+        auto it = numbers.begin();
+        for(int i = 0; i < 10; ++i)
+            ++it;
+        input_stream<int> copy = numbers;
+        THEN("the copy continues independently from the same position") {
+            REQUIRE(10 == *copy.begin());
+            REQUIRE(10 == *numbers.begin());
+            long sumCopy = 0, sumOriginal = 0;
+            for(int i : copy)
+                sumCopy += i;
+            for(span<const int> chunk : chunks(numbers, 100u))
+                sumOriginal = std::accumulate(chunk.begin(), chunk.end(), sumOriginal);
+            REQUIRE(499500L - 45L == sumCopy);
+            REQUIRE(sumCopy == sumOriginal);
+        }
     }
     
-    bool
-    compare_impl(const input_iterator& other) override {
-        return value == static_cast<running_integer const&>(other).value;
+    WHEN("a stream over a container is copied far into it") {
+        std::vector<int> values(1000000);
+        std::iota(values.begin(), values.end(), 0);
+        input_stream<int> large = std::move(values);
+        std::vector<int> block(300000);
+        large.read(block.data(), block.size());
+        input_stream<int> copy = large;
+        THEN("the copy starts where the original stands") {
+            REQUIRE(300000 == *copy.begin());
+            REQUIRE(300000 == *large.begin());
+        }
     }
     
-    int value;
-    
-public:
-    running_integer(int startVal)
-        : base_type()
-        , value(std::move(startVal))
-    {}
-    
-    ~running_integer() {
+    WHEN("it wraps a container") {
+        input_stream<int> samples = std::vector<int>{ 3, 1, 4, 1, 5 };
+        std::vector<int> read(samples.begin(), samples.end());
+        THEN("it yields the container's elements") {
+            REQUIRE((std::vector<int>{ 3, 1, 4, 1, 5 }) == read);
+        }
     }
-};
-
-
-
-
-TEST_CASE("ByteStreamFromFile","Stream") {
-   
 }
 
 
-template <typename Element> struct
-field {};
-
-
-
-template <typename E, typename...Es> struct
-container : container<E>, container<Es...> {
-    using container<E>::operator[];
-    using container<Es...>::operator[];
-    
-    void writeTo (std::ostream& ostr, size_t indent=0u) const {
-        static_cast<container<E> const*>(this)->writeTo(ostr,indent);
-        static_cast<container<Es...> const*>(this)->writeTo(ostr,indent);
-    }
+TEST_CASE("ByteStreamFromFile","Stream") {
+    struct sample {
+        uint32_t seq;
+        float value;
+    };
     
-    friend std::ostream& operator<< (std::ostream& ostr, const container& c) {
-        c.writeTo(ostr);
-        return ostr;
-    }
-};
-
-template <typename T> struct DataOutFormat {
-    static void writeTo(std::ostream& ostr, const T& val) {
-        ostr << val;
-    }
-};
-
-template <> struct
-DataOutFormat<std::string> {
-    static void writeTo(std::ostream& ostr, const std::string& str) {
-        ostr << "\"" << str << "\"";
-    }
-};
-
-template <typename Element> struct
-container<field<Element>>  {
-    auto&
-    operator[](field<Element>) {
-        return value;
+    char path[] = "/tmp/ByteStreamFromFileXXXXXX";
+    const int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    const size_t recorded = 10000u;
+    {
+        std::vector<sample> samples(recorded);
+        for(uint32_t i = 0u; i < recorded; ++i)
+            samples[i] = sample{ i, i * 0.5f };
+        REQUIRE(static_cast<ssize_t>(recorded * sizeof(sample)) == ::write(fd, samples.data(), recorded * sizeof(sample)));
+        REQUIRE(3 == ::write(fd, "abc", 3));      // partial record at the end
+        ::close(fd);
     }
     
-    void writeTo (std::ostream& ostr, size_t indent=0u) const {
-        std::string s(indent,' ');
-        ostr << s << "SubContainer {\"" << Element{} << "\" \"" << Element{} << "\" {\n"
-             << s << "AttrContainer {\n";
-        value.writeTo(ostr,indent+4u);
-        ostr << s << "}\n";
-    }
-private:
-    typename Element::value_type value;
-};
-
-
-
-
-template <typename Element> struct
-container<Element> {
-    template <typename ElementIn>
-    std::enable_if_t<
-        std::is_same<ElementIn,Element>::value && Element{}.index() == ElementIn{}.index(),
-        typename Element::value_type&>
-    operator[](ElementIn) {
-        return value;
+    GIVEN("a record file with a window of one page") {
+        record_file<sample> file(path, 1u);
+        
+        THEN("it holds the complete records") {
+            REQUIRE(recorded == file.size());
+        }
+        
+        WHEN("it is iterated window by window") {
+            size_t windows = 0u, count = 0u;
+            bool inOrder = true;
+            for(span<const sample> records : file) {
+                ++windows;
+                for(const auto& s : records)
+                    inOrder = inOrder && s.seq == count++;
+            }
+            THEN("the windows cover all records in order") {
+                REQUIRE(inOrder);
+                REQUIRE(recorded == count);
+                REQUIRE((recorded + file.records_per_window() - 1u) / file.records_per_window() == windows);
+            }
+        }
+        
+        WHEN("its records are wrapped into an input_stream") {
+            input_stream<sample> stream = file.records();
+            double sum = 0.0;
+            size_t count = 0u;
+            for(const sample& s : stream) {
+                sum += s.value;
+                ++count;
+            }
+            THEN("every record is read once") {
+                REQUIRE(recorded == count);
+                REQUIRE(Approx(0.25 * (recorded - 1u) * recorded) == sum);
+            }
+        }
     }
     
-    template <typename ElementIn>
-    std::enable_if_t<
-        std::is_same<ElementIn,Element>::value && Element{}.index() == ElementIn{}.index(),
-        typename Element::value_type&>
-    operator[](ElementIn) const {
-        return value;
-    }
+    ::unlink(path);
     
-    void writeTo (std::ostream& ostr, size_t indent=0u) const {
-//        std::cout << "AAAAAAAAA" << printtype<attr>() << std::endl;
-        std::string s(indent,' ');
-        ostr << s << "Attr<" << Element{}.type_name() << "> { \n"
-             << s << "\tName \"" << Element{} << "\"\n"
-             << s << "\tValue ";
-        DataOutFormat<decltype(value)>::writeTo(ostr,value);
-        ostr << s << "\n"
-             << s << "}\n";
+    WHEN("the file does not exist") {
+        THEN("opening it throws") {
+            REQUIRE_THROWS_AS(record_file<sample>{path}, std::system_error);
+        }
     }
-
-    typename Element::value_type value;
-};
-
-
-#define DEFER_(...) __VA_ARGS__
-#define DEFER(...) DEFER_(__VA_ARGS__)
-#define CONCATENATE(X,Y,Z)  X ## Y ## Z
-#define STRUCT(NAME)  CONCATENATE( S_,NAME, )
-#define FIELD(NAME)   CONCATENATE( F_,NAME, )
-#define TYPE(NAME)    CONCATENATE( T_,NAME, )
-
-#define SYMBOLIC(NAME,TYPE) \
-    static constexpr struct STRUCT(NAME) { \
-        constexpr operator const char*() const { return #NAME; } \
-        constexpr const char* type_name() const { return #TYPE; } \
-        constexpr int index() const { return __COUNTER__; } \
-        using value_type = TYPE; \
-    } NAME {};
-
-
-#define SYMBOLIC_F(NAME,T) \
-    struct STRUCT(T) { \
-        constexpr operator const char*() const { return #NAME; } \
-        constexpr const char* type_name() const { return #T; } \
-        constexpr int index() const { return __COUNTER__; } \
-        using value_type = T; \
-    }; \
-    constexpr field<STRUCT(T)> NAME {};
-
-#define CONTAINER_BEGIN(NAME) \
-    using TYPE(NAME) = container<
-#define ATTR_DECL(ATTR) \
-    std::decay_t<decltype(FIELD(ATTR))>
-#define CONTAINER_END() \
-    >;
-
-#define CONTAINER_DECL_BEGIN(NAME) \
-    namespace FIELD(NAME) {
-#define CONTAINER_DECL_END() \
-    }
-
-
-
-#define ATTR(NAME,TYPE) NAME, TYPE
-#define APPLY_TO(F, ...) F(__VA_ARGS__)
+}
 
 
 CONTAINER_DECL_BEGIN(Sensor)
@@ -386,6 +285,254 @@ TEST_CASE("tree","mpl") {
 //    std::cout << ":::::::::" << printtype<decltype(params[SensorField])>() << std::endl;
 }
 
+SCENARIO("parameter trees are encoded to and decoded from a binary blob","[container]") {
+    using namespace F_ScannerParams;
+    namespace S = F_Sensor;
+    namespace M = F_Mirror;
+
+    GIVEN("scanner parameters") {
+        T_ScannerParams params;
+        params[SensorField][S::Name] = "apd-left";
+        params[SensorField][S::SensorType] = 3;
+        params[SensorField][S::DistOffset] = -0.125;
+        params[SensorField][S::ApdHv] = 57.3;
+        params[MirrorField][M::Name] = "polygon";
+        params[MirrorField][M::TriggerOffset] = -42;
+
+        const auto blob = encode(params);
+
+        THEN("every element is a tag, a size and its payload") {
+            const size_t header = container_binary::header_size;
+            const size_t sensor = 4u*header + 8u + sizeof(int) + 2u*sizeof(double);
+            const size_t mirror = 2u*header + 7u + sizeof(int);
+            REQUIRE(blob.size() == 2u*header + sensor + mirror);
+            REQUIRE(container_binary::load_le<uint16_t>(blob.data()) == F_ScannerParams::S_T_Sensor{}.index());
+            REQUIRE(container_binary::load_le<uint32_t>(blob.data() + 2) == sensor);
+            REQUIRE(container_binary::load_le<uint16_t>(blob.data() + header) == S::Name.index());
+        }
+        THEN("the tags are hashes of the names, the same in every build") {
+            REQUIRE(container_binary::load_le<uint16_t>(blob.data()) == 49162u);
+            REQUIRE(container_binary::load_le<uint16_t>(blob.data() + container_binary::header_size) == 31974u);
+            REQUIRE(S::Name.index() == M::Name.index());
+        }
+        WHEN("it is decoded") {
+            const auto copy = decode<T_ScannerParams>(blob);
+            THEN("all values come back") {
+                REQUIRE(copy[SensorField][S::Name] == "apd-left");
+                REQUIRE(copy[SensorField][S::SensorType] == 3);
+                REQUIRE(copy[SensorField][S::DistOffset] == -0.125);
+                REQUIRE(copy[SensorField][S::ApdHv] == 57.3);
+                REQUIRE(copy[MirrorField][M::Name] == "polygon");
+                REQUIRE(copy[MirrorField][M::TriggerOffset] == -42);
+                REQUIRE(encode(copy) == blob);
+            }
+        }
+        WHEN("it is encoded again into the same buffer") {
+            std::vector<uint8_t> buffer;
+            encode(params, buffer);
+            const auto capacity = buffer.capacity();
+            const auto* data = buffer.data();
+            params[MirrorField][M::TriggerOffset] = 7;
+            encode(params, buffer);
+            THEN("the buffer is reused") {
+                REQUIRE(buffer.capacity() == capacity);
+                REQUIRE(buffer.data() == data);
+                REQUIRE(decode<T_ScannerParams>(buffer)[MirrorField][M::TriggerOffset] == 7);
+            }
+        }
+        WHEN("it is read through a view") {
+            const container_view<T_ScannerParams> view(blob);
+            THEN("values are read in place") {
+                const auto sensor = view[SensorField];
+                const span<const char> name = sensor[S::Name];
+                REQUIRE(std::string(name.begin(), name.end()) == "apd-left");
+                REQUIRE(name.data() == reinterpret_cast<const char*>(blob.data()) + 2u*container_binary::header_size);
+                REQUIRE(sensor[S::ApdHv] == 57.3);
+                REQUIRE(view[MirrorField][M::TriggerOffset] == -42);
+            }
+        }
+        WHEN("the blob is damaged") {
+            THEN("decoding reports where") {
+                auto truncated = blob;
+                truncated.pop_back();
+                REQUIRE_THROWS_AS(decode<T_ScannerParams>(truncated), decode_error);
+                REQUIRE_THROWS_AS(container_view<T_ScannerParams>{truncated}, decode_error);
+
+                auto retagged = blob;
+                retagged[0] ^= 0xFF;
+                try {
+                    decode<T_ScannerParams>(retagged);
+                    FAIL("decoded a wrong tag");
+                } catch(const decode_error& e) {
+                    REQUIRE(e.offset == 0u);
+                }
+
+                T_Mirror mirror;
+                REQUIRE_THROWS_AS(decode(blob, mirror), decode_error);
+            }
+        }
+    }
+}
+
+SCENARIO("parameter trees are read back from their text form","[container]") {
+    using namespace F_ScannerParams;
+    namespace S = F_Sensor;
+    namespace M = F_Mirror;
+
+    GIVEN("scanner parameters written as text") {
+        T_ScannerParams params;
+        params[SensorField][S::Name] = "apd left";
+        params[SensorField][S::SensorType] = 3;
+        params[SensorField][S::DistOffset] = -0.125;
+        params[SensorField][S::ApdHv] = 57.3;
+        params[MirrorField][M::Name] = "polygon";
+        params[MirrorField][M::TriggerOffset] = -42;
+        std::ostringstream text;
+        params.writeTo(text);
+
+        WHEN("the text is parsed") {
+            T_ScannerParams copy;
+            parse(span<const char>(text.str().data(), text.str().size()), copy);
+            THEN("all values come back") {
+                REQUIRE(copy[SensorField][S::Name] == "apd left");
+                REQUIRE(copy[SensorField][S::SensorType] == 3);
+                REQUIRE(copy[SensorField][S::DistOffset] == -0.125);
+                REQUIRE(copy[SensorField][S::ApdHv] == 57.3);
+                REQUIRE(copy[MirrorField][M::Name] == "polygon");
+                REQUIRE(copy[MirrorField][M::TriggerOffset] == -42);
+            }
+        }
+        WHEN("several sets are read through one reader") {
+            container_reader reader;
+            std::vector<T_ScannerParams> sets(3);
+            for(auto& set : sets) {
+                std::istringstream in(text.str());
+                reader.read(in, set);
+            }
+            THEN("each set is complete") {
+                for(auto& set : sets) {
+                    REQUIRE(set[SensorField][S::ApdHv] == 57.3);
+                    REQUIRE(set[MirrorField][M::Name] == "polygon");
+                }
+            }
+        }
+    }
+    GIVEN("text with elements out of order and some left out") {
+        const std::string text =
+            "SubContainer {\"MirrorField\" \"MirrorField\" {\n"
+            "AttrContainer {\n"
+            "  Attr<int> { Name \"TriggerOffset\" Value 12 }\n"
+            "}\n"
+            "SubContainer {\"SensorField\" \"SensorField\" {\n"
+            "AttrContainer {\n"
+            "  Attr<double> { Name \"ApdHv\" Value 1e2 }\n"
+            "  Attr<std::string> { Name \"Name\" Value \"\" }\n"
+            "}\n";
+        T_ScannerParams params;
+        params[SensorField][S::SensorType] = 5;
+        params[SensorField][S::Name] = "old";
+        parse(span<const char>(text.data(), text.size()), params);
+        THEN("the elements are found by name and the others keep their values") {
+            REQUIRE(params[MirrorField][M::TriggerOffset] == 12);
+            REQUIRE(params[SensorField][S::ApdHv] == 100.0);
+            REQUIRE(params[SensorField][S::Name] == "");
+            REQUIRE(params[SensorField][S::SensorType] == 5);
+        }
+    }
+    GIVEN("malformed text") {
+        auto error = [](const std::string& text) {
+            T_ScannerParams params;
+            try {
+                parse(span<const char>(text.data(), text.size()), params);
+            } catch(const parse_error& e) {
+                return std::make_pair(e.line, e.column);
+            }
+            return std::make_pair(size_t(0u), size_t(0u));
+        };
+        const std::string head = "SubContainer {\"SensorField\" \"SensorField\" {\nAttrContainer {\n";
+        THEN("errors carry the line and column") {
+            REQUIRE(error(head + "  Attr<double> { Name \"Apd\" Value 1 }\n}\n") == std::make_pair(size_t(3u), size_t(23u)));
+            REQUIRE(error(head + "  Attr<int> { Name \"ApdHv\" Value 1 }\n}\n") == std::make_pair(size_t(3u), size_t(3u)));
+            REQUIRE(error(head + "  Attr<int> { Name \"SensorType\" Value 1.5 }\n}\n") == std::make_pair(size_t(3u), size_t(39u)));
+            REQUIRE(error(head + "  Attr<int> { Name \"SensorType\" Value 99999999999 }\n}\n").first == 3u);
+            REQUIRE(error(head + "  Attr<int> { Name \"SensorType\" Value 1 }\n").first == 4u);
+            REQUIRE(error(head + "  Attr<std::string> { Name \"Name\" Value \"open\n}\n").first == 3u);
+            REQUIRE(error("AttrContainer {\n").first == 1u);
+        }
+    }
+}
+
+SCENARIO("parameter trees are updated with patches of the changed fields","[container]") {
+    using namespace F_ScannerParams;
+    namespace S = F_Sensor;
+    namespace M = F_Mirror;
+
+    GIVEN("a parameter set on the device and a changed copy") {
+        T_ScannerParams device;
+        device[SensorField][S::Name] = "apd";
+        device[SensorField][S::SensorType] = 3;
+        device[SensorField][S::DistOffset] = 0.5;
+        device[SensorField][S::ApdHv] = 57.3;
+        device[MirrorField][M::Name] = "polygon";
+        device[MirrorField][M::TriggerOffset] = -42;
+        T_ScannerParams host = device;
+
+        WHEN("nothing changed") {
+            THEN("the patch is empty") {
+                REQUIRE(diff(device, host).empty());
+            }
+        }
+        WHEN("one attribute changed") {
+            host[SensorField][S::ApdHv] = 58.0;
+            const auto patch = diff(device, host);
+            THEN("the patch holds only that attribute below its field") {
+                REQUIRE(patch.size() == 2u*container_binary::header_size + sizeof(double));
+                REQUIRE(patch.size() < encode(host).size() / 3u);
+                apply(patch, device);
+                REQUIRE(device[SensorField][S::ApdHv] == 58.0);
+                REQUIRE(encode(device) == encode(host));
+            }
+            THEN("its bytes depend only on the names, so firmware built elsewhere can apply it") {
+                const std::vector<uint8_t> expected {
+                    0x0A, 0xC0, 14, 0, 0, 0,                 // SensorField, 14 bytes
+                    0x5D, 0x65,  8, 0, 0, 0,                 // ApdHv, 8 bytes
+                    0, 0, 0, 0, 0, 0, 0x4D, 0x40             // 58.0
+                };
+                REQUIRE(patch == expected);
+            }
+        }
+        WHEN("attributes in both fields changed") {
+            host[SensorField][S::SensorType] = 4;
+            host[MirrorField][M::Name] = "galvo";
+            std::vector<uint8_t> patch;
+            diff(device, host, patch);
+            apply(patch, device);
+            THEN("applying the patch makes the trees equal") {
+                REQUIRE(device[SensorField][S::SensorType] == 4);
+                REQUIRE(device[MirrorField][M::Name] == "galvo");
+                REQUIRE(encode(device) == encode(host));
+                REQUIRE(diff(device, host).empty());
+            }
+        }
+        WHEN("a patch is malformed") {
+            host[SensorField][S::ApdHv] = 58.0;
+            host[MirrorField][M::TriggerOffset] = 1;
+            const auto patch = diff(device, host);
+            THEN("apply throws") {
+                auto truncated = patch;
+                truncated.pop_back();
+                REQUIRE_THROWS_AS(apply(truncated, device), decode_error);
+
+                const auto mirror = diff(device[MirrorField], host[MirrorField]);
+                REQUIRE_THROWS_AS(apply(mirror, device), decode_error);
+
+                T_Sensor sensor;
+                REQUIRE_THROWS_AS(apply(patch, sensor), decode_error);
+            }
+        }
+    }
+}
+
 
 
 
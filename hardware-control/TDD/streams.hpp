@@ -9,6 +9,337 @@
 #ifndef streams_hpp
 #define streams_hpp
 
-#include <stdio.h>
+#include <TDD/span.h>
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// Ranges over statically known sources use concrete iterator types that the
+/// compiler can inline. Type erasure is opt-in: wrap a range in an
+/// input_stream<T> where it crosses an API boundary. chunks() iterates any
+/// range in spans of elements, so consumers can work on blocks at a time.
+
+
+/// Counts up from a start value. Copies count on independently, so it is a
+/// forward iterator.
+class
+running_integer {
+    int value;
+    
+public:
+    using value_type = int;
+    using difference_type = std::ptrdiff_t;
+    using reference = const int&;
+    using pointer = const int*;
+    using iterator_category = std::forward_iterator_tag;
+    
+    explicit running_integer(int startVal = 0)
+        : value(startVal)
+    {}
+    
+    const int& operator* () const { return value; }
+    
+    running_integer& operator++() {
+        ++value;
+        return *this;
+    }
+    
+    running_integer operator++(int) {
+        auto copy(*this);
+        ++value;
+        return copy;
+    }
+    
+    friend bool operator == (const running_integer& a, const running_integer& b) { return a.value == b.value; }
+    
+    friend bool operator != (const running_integer& a, const running_integer& b) { return a.value != b.value; }
+};
+
+
+template <typename Iterator, typename Sentinel = Iterator> class
+range {
+    Iterator first;
+    Sentinel last;
+    
+public:
+    using value_type = std::decay_t<decltype(*std::declval<Iterator&>())>;
+    
+    range(Iterator first, Sentinel last)
+        : first(std::move(first)), last(std::move(last))
+    {}
+    
+    Iterator begin() const { return first; }
+    
+    Sentinel end() const { return last; }
+};
+
+template <typename Iterator, typename Sentinel>
+range<Iterator,Sentinel> make_range(Iterator first, Sentinel last) {
+    return { std::move(first), std::move(last) };
+}
+
+/// the integers in [first, last)
+inline range<running_integer> running_integers(int first, int last) {
+    return { running_integer(first), running_integer(last) };
+}
+
+
+namespace detail {
+    template <typename Range, typename = void> struct
+    is_contiguous : std::false_type {};
+    
+    template <typename Range> struct
+    is_contiguous<Range,decltype(void(std::declval<Range&>().data()), void(std::declval<Range&>().size()))> : std::true_type {};
+    
+    template <typename Range> using
+    range_value_t = std::decay_t<decltype(*std::begin(std::declval<Range&>()))>;
+}
+
+
+template <typename Range, bool Contiguous = detail::is_contiguous<std::remove_reference_t<Range>>::value> class
+chunked_range;
+
+/// Chunks of a contiguous range are views into its storage.
+template <typename Range> class
+chunked_range<Range,true> {
+    using T = detail::range_value_t<Range>;
+    
+    Range source;
+    size_t chunkSize;
+    
+public:
+    class iterator {
+        const T* pos;
+        const T* last;
+        size_t chunkSize;
+        
+        size_t length() const { return std::min(chunkSize, static_cast<size_t>(last - pos)); }
+        
+    public:
+        using value_type = span<const T>;
+        using difference_type = std::ptrdiff_t;
+        using reference = span<const T>;
+        using pointer = void;
+        using iterator_category = std::input_iterator_tag;
+        
+        iterator(const T* pos, const T* last, size_t chunkSize) : pos(pos), last(last), chunkSize(chunkSize) {}
+        
+        span<const T> operator* () const { return { pos, length() }; }
+        
+        iterator& operator++() {
+            pos += length();
+            return *this;
+        }
+        
+        friend bool operator == (const iterator& a, const iterator& b) { return a.pos == b.pos; }
+        
+        friend bool operator != (const iterator& a, const iterator& b) { return a.pos != b.pos; }
+    };
+    
+    chunked_range(Range&& source, size_t chunkSize)
+        : source(std::forward<Range>(source)), chunkSize(chunkSize)
+    {}
+    
+    iterator begin() const { return { source.data(), source.data() + source.size(), chunkSize }; }
+    
+    iterator end() const { return { source.data() + source.size(), source.data() + source.size(), chunkSize }; }
+};
+
+/// Other ranges are copied chunk by chunk into a buffer that is reused, so a
+/// chunk is only valid until the next one is read. Single pass.
+template <typename Range> class
+chunked_range<Range,false> {
+    using T = detail::range_value_t<Range>;
+    using source_iterator = decltype(std::begin(std::declval<Range&>()));
+    using source_sentinel = decltype(std::end(std::declval<Range&>()));
+    
+    Range source;
+    size_t chunkSize;
+    std::vector<T> buffer;
+    std::unique_ptr<std::pair<source_iterator,source_sentinel>> pos;
+    
+    void fill() {
+        buffer.clear();
+        for(; buffer.size() < chunkSize && pos->first != pos->second; ++pos->first)
+            buffer.push_back(*pos->first);
+    }
+    
+public:
+    class iterator {
+        chunked_range* owner;
+        
+        bool done() const { return !owner || owner->buffer.empty(); }
+        
+    public:
+        using value_type = span<const T>;
+        using difference_type = std::ptrdiff_t;
+        using reference = span<const T>;
+        using pointer = void;
+        using iterator_category = std::input_iterator_tag;
+        
+        explicit iterator(chunked_range* owner) : owner(owner) {}
+        
+        span<const T> operator* () const { return owner->buffer; }
+        
+        iterator& operator++() {
+            owner->fill();
+            return *this;
+        }
+        
+        friend bool operator == (const iterator& a, const iterator& b) { return a.done() == b.done(); }
+        
+        friend bool operator != (const iterator& a, const iterator& b) { return a.done() != b.done(); }
+    };
+    
+    chunked_range(Range&& source, size_t chunkSize)
+        : source(std::forward<Range>(source)), chunkSize(chunkSize)
+    {
+        buffer.reserve(chunkSize);
+    }
+    
+    iterator begin() {
+        pos.reset(new std::pair<source_iterator,source_sentinel>(std::begin(source), std::end(source)));
+        fill();
+        return iterator(this);
+    }
+    
+    iterator end() { return iterator(nullptr); }
+};
+
+/// iterates range in spans of up to chunkSize elements; an lvalue range is referenced, an rvalue range is kept
+template <typename Range>
+chunked_range<Range> chunks(Range&& source, size_t chunkSize) {
+    return { std::forward<Range>(source), chunkSize };
+}
+
+
+/// Type-erased single-pass stream of T. The source behind it is pulled in
+/// blocks with one virtual call each, also when iterating element by element.
+/// Copies read on independently from the position of the original, so the
+/// source has to be a multi-pass range: copies of single-pass iterators such
+/// as std::istreambuf_iterator share their input and would consume each
+/// other's elements.
+template <typename T> class
+input_stream {
+    struct source {
+        virtual ~source() {}
+        virtual size_t read(T* out, size_t max) = 0;
+        virtual std::unique_ptr<source> clone() const = 0;
+    };
+    
+    template <typename Range> struct
+    concrete final : source {
+        using source_iterator = decltype(std::begin(std::declval<Range&>()));
+        using source_sentinel = decltype(std::end(std::declval<Range&>()));
+        
+        Range r;
+        source_iterator pos;
+        source_sentinel last;
+        size_t consumed = 0u;
+        
+        explicit concrete(Range rIn) : r(std::move(rIn)), pos(std::begin(r)), last(std::end(r)) {}
+        
+        size_t read(T* out, size_t max) override {
+            size_t n = 0u;
+            for(; n < max && pos != last; ++pos, ++n)
+                out[n] = *pos;
+            consumed += n;
+            return n;
+        }
+        
+        /// the copy's iterators must refer to its own copy of the range;
+        /// std::next skips the consumed elements in O(1) for random access sources
+        std::unique_ptr<source> clone() const override {
+            std::unique_ptr<concrete> copy(new concrete(r));
+            copy->pos = std::next(copy->pos, static_cast<typename std::iterator_traits<source_iterator>::difference_type>(consumed));
+            copy->consumed = consumed;
+            return copy;
+        }
+    };
+    
+    static constexpr size_t blockSize = 256u;
+    
+    std::unique_ptr<source> src;
+    std::vector<T> buffer;
+    size_t next = 0u;
+    
+    bool refill() {
+        buffer.resize(blockSize);
+        buffer.resize(src->read(buffer.data(), blockSize));
+        next = 0u;
+        return !buffer.empty();
+    }
+    
+public:
+    class iterator {
+        input_stream* owner;
+        
+        bool done() const { return !owner || owner->next == owner->buffer.size(); }
+        
+    public:
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using reference = const T&;
+        using pointer = const T*;
+        using iterator_category = std::input_iterator_tag;
+        
+        explicit iterator(input_stream* owner) : owner(owner) {}
+        
+        const T& operator* () const { return owner->buffer[owner->next]; }
+        
+        const T* operator-> () const { return &owner->buffer[owner->next]; }
+        
+        iterator& operator++() {
+            if(++owner->next == owner->buffer.size())
+                owner->refill();
+            return *this;
+        }
+        
+        friend bool operator == (const iterator& a, const iterator& b) { return a.done() == b.done(); }
+        
+        friend bool operator != (const iterator& a, const iterator& b) { return a.done() != b.done(); }
+    };
+    
+    template <typename Range, typename = std::enable_if_t<!std::is_same<std::decay_t<Range>,input_stream>::value>>
+    input_stream(Range r)
+        : src(new concrete<Range>(std::move(r)))
+    {
+        static_assert(std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<typename concrete<Range>::source_iterator>::iterator_category>::value,
+                      "input_stream copies the position in its source, which needs a forward iterator");
+    }
+    
+    input_stream(const input_stream& other)
+        : src(other.src->clone()), buffer(other.buffer), next(other.next)
+    {}
+    
+    input_stream(input_stream&&) = default;
+    
+    input_stream& operator = (input_stream other) {
+        src = std::move(other.src);
+        buffer = std::move(other.buffer);
+        next = other.next;
+        return *this;
+    }
+    
+    /// reads up to max elements past the ones iterated already; 0 at the end
+    size_t read(T* out, size_t max) {
+        const size_t buffered = std::min(max, buffer.size() - next);
+        std::copy(buffer.begin() + next, buffer.begin() + next + buffered, out);
+        next += buffered;
+        return buffered + src->read(out + buffered, max - buffered);
+    }
+    
+    iterator begin() {
+        if(next == buffer.size())
+            refill();
+        return iterator(this);
+    }
+    
+    iterator end() { return iterator(nullptr); }
+};
 
 #endif /* streams_hpp */
@@ -7,130 +7,221 @@
 //
 
 #include "transducers.h"
+#include "streams.hpp"
+#include "window_transducers.h"
+#include "parallel_transduce.h"
 #include <catch.h>
-#include <iostream>
-#include <vector>
-#include <iterator>
 #include <algorithm>
-#include <streambuf>
-#include <sstream>
-#include <map>
-
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
-struct state {
-    std::vector<int> stack;
-    std::map<std::string,std::function<void(state&,std::istream&)>> dict;
-};
 
-template <typename T>
-void tryParse(state& s, std::istream& istr, std::function<T(std::istream&)> parse, std::function<void(state&,T)> action);
+using namespace transducers;
 
-template <>
-void tryParse(state& s, std::istream& istr, std::function<int(std::istream&)> parse, std::function<void(state&,int)> action) {
-    auto pos = istr.tellg();
-    try {
-        auto val = parse(istr);
-        action(s,val);
+namespace {
+    auto sum = [](int s, int x) { return s + x; };
+    
+    auto push = [](std::vector<int> v, int x) {
+        v.push_back(x);
+        return v;
+    };
+    
+    auto collect = [](std::vector<double> v, double x) {
+        v.push_back(x);
+        return v;
+    };
+    
+    /// deterministic noisy samples
+    std::vector<double> samples(size_t n) {
+        std::vector<double> v(n);
+        uint32_t seed = 12345u;
+        for(auto& x : v) {
+            seed = seed * 1664525u + 1013904223u;
+            x = static_cast<double>(seed >> 8) / (1u << 24) * 200.0 - 100.0;
+        }
+        return v;
     }
-    catch(...) {
-        istr.clear();
-        istr.seekg(pos);
+    
+    template <typename F>
+    std::vector<double> naive_windows(const std::vector<double>& x, size_t n, size_t stride, F stat) {
+        std::vector<double> out;
+        for(size_t i = 0u; i + n <= x.size(); i += stride)
+            out.push_back(stat(x.data() + i, x.data() + i + n));
+        return out;
+    }
+    
+    double mean(const double* first, const double* last) { return std::accumulate(first, last, 0.0) / (last - first); }
+    double rms(const double* first, const double* last) { return std::sqrt(std::inner_product(first, last, first, 0.0) / (last - first)); }
+    double minimum(const double* first, const double* last) { return *std::min_element(first, last); }
+    double maximum(const double* first, const double* last) { return *std::max_element(first, last); }
+    
+    bool close(const std::vector<double>& a, const std::vector<double>& b) {
+        if(a.size() != b.size())
+            return false;
+        for(size_t i = 0u; i < a.size(); ++i)
+            if(std::abs(a[i] - b[i]) > 1e-9 * (1.0 + std::abs(b[i])))
+                return false;
+        return true;
     }
 }
 
-std::vector<int> forth(state& s, std::istream& istr) {
-    auto pos = istr.tellg();
-    std::string token;
-    if(istr >> token) {
-        std::istringstream str(token);
-        int num;
-        if(str >> num) {
-            s.stack.push_back(num);
-            return forth(s,istr);
-        }
-        
-        if(s.dict.count(token)) {
-            s.dict.at(token)(s,istr);
-            return forth(s,istr);
-        }
+TEST_CASE("transducers") {
+    SECTION("map and filter fuse into one pass") {
+        const auto xf = map([](int x) { return x * x; }) | filter([](int x) { return x % 2 == 0; });
+        CHECK(transduce(xf, sum, 0, running_integers(0, 10)) == 0 + 4 + 16 + 36 + 64);
+    }
+    
+    SECTION("the order of composition is the order of the pipeline") {
+        const auto a = filter([](int x) { return x % 2 == 0; }) | map([](int x) { return x + 1; });
+        const auto b = map([](int x) { return x + 1; }) | filter([](int x) { return x % 2 == 0; });
+        CHECK(transduce(a, push, std::vector<int>{}, running_integers(0, 6)) == std::vector<int>({1, 3, 5}));
+        CHECK(transduce(b, push, std::vector<int>{}, running_integers(0, 6)) == std::vector<int>({2, 4, 6}));
+    }
+    
+    SECTION("take stops an endless source") {
+        const auto endless = make_range(running_integer(0), running_integer(-1));
+        const auto xf = filter([](int x) { return x % 3 == 0; }) | take(4);
+        CHECK(transduce(xf, push, std::vector<int>{}, endless) == std::vector<int>({0, 3, 6, 9}));
+        CHECK(transduce(take(0), push, std::vector<int>{}, endless).empty());
+    }
+    
+    SECTION("enumerate passes the index along") {
+        const std::vector<std::string> words { "a", "b", "c" };
+        const auto joined = transduce(enumerate(), [](std::string s, size_t n, const std::string& w) {
+            return s + std::to_string(n) + w;
+        }, std::string(), words);
+        CHECK(joined == "0a1b2c");
+    }
+    
+    SECTION("partition passes groups and the rest on completion") {
+        const auto xf = partition<int,3>() | map([](span<const int> group) {
+            int s = 0;
+            for(int x : group)
+                s = 10 * s + x;
+            return s;
+        });
+        CHECK(transduce(xf, push, std::vector<int>{}, running_integers(1, 9)) == std::vector<int>({123, 456, 78}));
+    }
+    
+    SECTION("partition does not pass the rest after take has finished") {
+        const auto xf = partition<int,2>() | map([](span<const int> group) { return int(group.size()); }) | take(2);
+        CHECK(transduce(xf, push, std::vector<int>{}, running_integers(0, 5)) == std::vector<int>({2, 2}));
     }
     
-    return s.stack;
+    SECTION("window passes the last N inputs, oldest first") {
+        const auto xf = window<int,3>() | map([](span<const int> w) { return 100 * w[0] + 10 * w[1] + w[2]; });
+        CHECK(transduce(xf, push, std::vector<int>{}, running_integers(1, 7)) == std::vector<int>({123, 234, 345, 456}));
+    }
+    
+    SECTION("dedupe drops repeated inputs") {
+        const std::vector<int> samples { 1, 1, 2, 2, 2, 1, 3, 3 };
+        CHECK(transduce(dedupe<int>(), push, std::vector<int>{}, samples) == std::vector<int>({1, 2, 1, 3}));
+    }
+    
+    SECTION("type-erased streams and chunks are sources as well") {
+        input_stream<int> stream(running_integers(0, 1000));
+        CHECK(transduce(map([](int x) { return x % 7; }) | dedupe<int>() | take(10), sum, 0, stream) == 0+1+2+3+4+5+6+0+1+2);
+        
+        const std::vector<int> samples(100, 1);
+        const auto blocks = transduce(map([](span<const int> chunk) { return int(chunk.size()); }), push, std::vector<int>{}, chunks(samples, 32));
+        CHECK(blocks == std::vector<int>({32, 32, 32, 4}));
+    }
 }
 
-TEST_CASE("transducers") {
-    state s{};
-    s.dict["+"] = [](state& s, std::istream& istr) {
-        auto a = s.stack.back(); s.stack.pop_back();
-        auto b = s.stack.back(); s.stack.pop_back();
-        s.stack.push_back(a+b);
-    };
-
-    s.dict["-"] = [](state& s, std::istream& istr) {
-        auto a = s.stack.back(); s.stack.pop_back();
-        auto b = s.stack.back(); s.stack.pop_back();
-        s.stack.push_back(b-a);
-    };
+TEST_CASE("window transducers") {
+    const auto x = samples(1000);
     
-    s.dict[":"] = [](state& s, std::istream& istr) {
-        std::string wordname;
-        auto pos = istr.tellg();
-        try {
-            if(istr >> wordname) {
-                struct mybuf : public std::streambuf {};
-                char buf[100u];
-                istr.get(buf,sizeof(buf),';');
-                char _;
-                istr.get(_);
-                std::string def(buf);
-                s.dict[wordname] = [def](state& s, std::istream& istr1) {
-                    std::istringstream defstr(def);
-                    forth(s,defstr);
-                };
-            }
-        }
-        catch(...) {
-            istr.seekg(pos);
-            throw;
-        }
-    };
+    SECTION("fixed windows match a direct computation, sample by sample and in chunks") {
+        CHECK(close(transduce(fixed_mean<16>(), collect, std::vector<double>{}, x), naive_windows(x, 16, 16, mean)));
+        CHECK(close(transduce(fixed_rms<16>(), collect, std::vector<double>{}, x), naive_windows(x, 16, 16, rms)));
+        CHECK(transduce(fixed_min<16>(), collect, std::vector<double>{}, x) == naive_windows(x, 16, 16, minimum));
+        CHECK(transduce(fixed_max<16>(), collect, std::vector<double>{}, x) == naive_windows(x, 16, 16, maximum));
+        
+        CHECK(close(transduce(fixed_mean<16>(), collect, std::vector<double>{}, chunks(x, 100)), naive_windows(x, 16, 16, mean)));
+        CHECK(close(transduce(fixed_rms<16>(), collect, std::vector<double>{}, chunks(x, 7)), naive_windows(x, 16, 16, rms)));
+        CHECK(transduce(fixed_min<16>(), collect, std::vector<double>{}, chunks(x, 33)) == naive_windows(x, 16, 16, minimum));
+        CHECK(transduce(fixed_max<16>(), collect, std::vector<double>{}, chunks(x, 1000)) == naive_windows(x, 16, 16, maximum));
+    }
     
+    SECTION("sliding windows match a direct computation") {
+        CHECK(close(transduce(sliding_mean<10>(), collect, std::vector<double>{}, x), naive_windows(x, 10, 1, mean)));
+        CHECK(close(transduce(sliding_rms<10>(), collect, std::vector<double>{}, chunks(x, 64)), naive_windows(x, 10, 1, rms)));
+        CHECK(transduce(sliding_min<10>(), collect, std::vector<double>{}, x) == naive_windows(x, 10, 1, minimum));
+        CHECK(transduce(sliding_max<10>(), collect, std::vector<double>{}, chunks(x, 64)) == naive_windows(x, 10, 1, maximum));
+        CHECK(transduce(sliding_max<1>(), collect, std::vector<double>{}, x) == x);
+    }
     
-    SECTION("0") {
-        std::istringstream stream("0");
-        CHECK(forth(s, stream) == std::vector<int>{0});
+    SECTION("sliding extremes of monotonic input") {
+        CHECK(transduce(sliding_min<3>(), collect, std::vector<double>{}, running_integers(0, 6)) == std::vector<double>({0, 1, 2, 3}));
+        CHECK(transduce(sliding_max<3>(), collect, std::vector<double>{}, running_integers(0, 6)) == std::vector<double>({2, 3, 4, 5}));
     }
     
-    SECTION("1") {
-        std::istringstream stream("1");
-        CHECK(forth(s, stream) == std::vector<int>{1});
+    SECTION("windows stop early inside a chunk") {
+        CHECK(transduce(fixed_mean<4>() | take(3), collect, std::vector<double>{}, chunks(x, 1000)).size() == 3u);
+        CHECK(transduce(sliding_mean<4>() | take(3), collect, std::vector<double>{}, chunks(x, 1000)).size() == 3u);
     }
     
-    SECTION("1 2") {
-        std::istringstream stream("1 2");
-        CHECK(forth(s, stream) == std::vector<int>({1, 2}));
+    SECTION("CIC decimation settles on a constant input") {
+        const std::vector<int> constant(64, -7);
+        const auto out = transduce(cic_decimate<3>(8), collect, std::vector<double>{}, constant);
+        REQUIRE(out.size() == 8u);
+        for(size_t i = 3u; i < out.size(); ++i)
+            CHECK(out[i] == -7.0);
     }
     
-    SECTION("1 2 +") {
-        std::istringstream stream("1 2 +");
-        CHECK(forth(s, stream) == std::vector<int>({3}));
+    SECTION("CIC decimation of a ramp is the delayed window mean") {
+        const auto out = transduce(cic_decimate<1>(4), collect, std::vector<double>{}, running_integers(0, 16));
+        CHECK(out == std::vector<double>({1.5, 5.5, 9.5, 13.5}));
     }
     
-    SECTION("10 2 - 100 +") {
-        std::istringstream stream("10 2 - 100 +");
-        CHECK(forth(s, stream) == std::vector<int>({108}));
+    SECTION("exponential smoothing approaches a step") {
+        const std::vector<double> step { 0, 10, 10, 10 };
+        CHECK(transduce(exp_smooth(0.5), collect, std::vector<double>{}, step) == std::vector<double>({0, 5, 7.5, 8.75}));
     }
+}
+
+TEST_CASE("parallel transduce") {
+    const auto x = samples(100000);
+    auto add = [](double s, double v) { return s + v; };
     
-    SECTION(": plus6 1 + 5 + ; 3 plus6") {
-        std::istringstream stream(": plus6 1 + 5 + ; 3 plus6");
-        CHECK(forth(s, stream) == std::vector<int>({9}));
+    SECTION("matches the sequential result") {
+        std::vector<int> ints(10000);
+        std::iota(ints.begin(), ints.end(), 0);
+        const auto xf = map([](int v) { return v * 3; }) | filter([](int v) { return v % 2 == 0; });
+        CHECK(parallel_transduce(xf, sum, sum, 0, ints, { 64u, 4u }) == transduce(xf, sum, 0, ints));
+        CHECK(parallel_reduce(sum, sum, 0, ints, { 100u, 3u }) == std::accumulate(ints.begin(), ints.end(), 0));
     }
     
+    SECTION("is deterministic for any number of threads") {
+        const double one = parallel_reduce(add, add, 0.0, x, { 1000u, 1u });
+        for(size_t threads : { 2u, 3u, 8u, 0u })
+            CHECK(parallel_reduce(add, add, 0.0, x, { 1000u, threads }) == one);
+        CHECK(std::abs(one - std::accumulate(x.begin(), x.end(), 0.0)) < 1e-6);
+    }
     
-    auto enumerate = [](auto step) {
-        return [step,n=0](auto s, auto...ins) mutable {
-            return step(s, n++, ins...);
+    SECTION("combines the partial states in input order") {
+        std::vector<int> ints(1000);
+        std::iota(ints.begin(), ints.end(), 0);
+        auto append = [](std::vector<int> a, std::vector<int> b) {
+            a.insert(a.end(), b.begin(), b.end());
+            return a;
         };
-    };
+        CHECK(parallel_reduce(push, append, std::vector<int>{}, ints, { 7u, 4u }) == ints);
+    }
+    
+    SECTION("empty input gives init") {
+        CHECK(parallel_reduce(sum, sum, 5, std::vector<int>{}) == 5);
+    }
     
-}
\ No newline at end of file
+    SECTION("rethrows what a worker threw") {
+        auto fail = [](double s, double v) {
+            if(v > 99.99)
+                throw std::runtime_error("out of range");
+            return s + v;
+        };
+        CHECK_THROWS_AS(parallel_reduce(fail, add, 0.0, x, { 100u, 4u }), std::runtime_error);
+    }
+}
@@ -9,7 +9,256 @@
 #ifndef __hardware_control__transducers__
 #define __hardware_control__transducers__
 
+#include <TDD/span.h>
+#include <array>
+#include <cstddef>
+#include <utility>
 
+/// Transducers transform a step function state = step(state, inputs...)
+/// into another one. map(f) | filter(p) | take(n) composes at compile time
+/// into a single nested step object, and transduce() runs it over any range
+/// or stream in one pass without intermediate containers.
+///
+/// A step object has
+///     S operator()(S state, inputs...)   one step
+///     bool done() const                  true once it takes no more input
+///     S complete(S state)                flushes buffered input at the end
+/// A transducer wraps the next step object into its own; done() and
+/// complete() are passed on, which is how take() stops an endless source.
+/// partition, window and dedupe keep elements and need their type.
 
+namespace transducers {
+
+    /// plain step function as the last step object
+    template <typename F> struct
+    completing {
+        F f;
+        
+        template <typename S, typename...In>
+        S operator()(S state, In&&...in) { return f(std::move(state), std::forward<In>(in)...); }
+        
+        bool done() const { return false; }
+        
+        template <typename S>
+        S complete(S state) { return state; }
+    };
+    
+    template <typename Make> struct
+    xform {
+        Make make;
+        
+        template <typename RF>
+        auto operator()(RF rf) const { return make(std::move(rf)); }
+    };
+    
+    template <typename Make>
+    xform<Make> make_xform(Make make) {
+        return { std::move(make) };
+    }
+    
+    /// a | b feeds what a passes on into b
+    template <typename A, typename B>
+    auto operator| (xform<A> a, xform<B> b) {
+        return make_xform([a,b](auto rf) { return a(b(std::move(rf))); });
+    }
+    
+    
+    
+    template <typename RF, typename F> struct
+    map_step {
+        RF rf;
+        F f;
+        
+        template <typename S, typename...In>
+        S operator()(S state, In&&...in) { return rf(std::move(state), f(std::forward<In>(in)...)); }
+        
+        bool done() const { return rf.done(); }
+        
+        template <typename S>
+        S complete(S state) { return rf.complete(std::move(state)); }
+    };
+    
+    template <typename F>
+    auto map(F f) {
+        return make_xform([f](auto rf) { return map_step<decltype(rf),F>{ std::move(rf), f }; });
+    }
+    
+    template <typename RF, typename P> struct
+    filter_step {
+        RF rf;
+        P pred;
+        
+        template <typename S, typename...In>
+        S operator()(S state, In&&...in) {
+            if(!pred(in...))
+                return state;
+            return rf(std::move(state), std::forward<In>(in)...);
+        }
+        
+        bool done() const { return rf.done(); }
+        
+        template <typename S>
+        S complete(S state) { return rf.complete(std::move(state)); }
+    };
+    
+    template <typename P>
+    auto filter(P pred) {
+        return make_xform([pred](auto rf) { return filter_step<decltype(rf),P>{ std::move(rf), pred }; });
+    }
+    
+    template <typename RF> struct
+    take_step {
+        RF rf;
+        size_t left;
+        
+        template <typename S, typename...In>
+        S operator()(S state, In&&...in) {
+            --left;
+            return rf(std::move(state), std::forward<In>(in)...);
+        }
+        
+        bool done() const { return left == 0u || rf.done(); }
+        
+        template <typename S>
+        S complete(S state) { return rf.complete(std::move(state)); }
+    };
+    
+    inline auto take(size_t n) {
+        return make_xform([n](auto rf) { return take_step<decltype(rf)>{ std::move(rf), n }; });
+    }
+    
+    /// passes the running index in front of the inputs
+    template <typename RF> struct
+    enumerate_step {
+        RF rf;
+        size_t n;
+        
+        template <typename S, typename...In>
+        S operator()(S state, In&&...in) { return rf(std::move(state), n++, std::forward<In>(in)...); }
+        
+        bool done() const { return rf.done(); }
+        
+        template <typename S>
+        S complete(S state) { return rf.complete(std::move(state)); }
+    };
+    
+    inline auto enumerate() {
+        return make_xform([](auto rf) { return enumerate_step<decltype(rf)>{ std::move(rf), 0u }; });
+    }
+    
+    /// passes groups of N as span<const T>; a shorter last group is passed on completion
+    template <typename RF, typename T, size_t N> struct
+    partition_step {
+        RF rf;
+        std::array<T,N> group;
+        size_t count;
+        
+        template <typename S, typename In>
+        S operator()(S state, In&& in) {
+            group[count++] = std::forward<In>(in);
+            if(count < N)
+                return state;
+            count = 0u;
+            return rf(std::move(state), span<const T>(group.data(), N));
+        }
+        
+        bool done() const { return rf.done(); }
+        
+        template <typename S>
+        S complete(S state) {
+            if(count != 0u && !rf.done())
+                state = rf(std::move(state), span<const T>(group.data(), count));
+            count = 0u;
+            return rf.complete(std::move(state));
+        }
+    };
+    
+    template <typename T, size_t N>
+    auto partition() {
+        static_assert(N > 0u, "partitions need at least one element");
+        return make_xform([](auto rf) { return partition_step<decltype(rf),T,N>{ std::move(rf), {}, 0u }; });
+    }
+    
+    /// Passes the last N inputs, oldest first, as span<const T> once N have
+    /// arrived. Each input is stored twice, at i and i + N, so the window is
+    /// always contiguous without copying.
+    template <typename RF, typename T, size_t N> struct
+    window_step {
+        RF rf;
+        std::array<T,2*N> ring;
+        size_t next;
+        size_t filled;
+        
+        template <typename S, typename In>
+        S operator()(S state, In&& in) {
+            ring[next] = in;
+            ring[next + N] = std::forward<In>(in);
+            next = next + 1u == N ? 0u : next + 1u;
+            if(filled < N && ++filled < N)
+                return state;
+            return rf(std::move(state), span<const T>(ring.data() + next, N));
+        }
+        
+        bool done() const { return rf.done(); }
+        
+        template <typename S>
+        S complete(S state) { return rf.complete(std::move(state)); }
+    };
+    
+    template <typename T, size_t N>
+    auto window() {
+        static_assert(N > 0u, "windows need at least one element");
+        return make_xform([](auto rf) { return window_step<decltype(rf),T,N>{ std::move(rf), {}, 0u, 0u }; });
+    }
+    
+    /// drops inputs equal to the one before
+    template <typename RF, typename T> struct
+    dedupe_step {
+        RF rf;
+        T last;
+        bool any;
+        
+        template <typename S, typename In>
+        S operator()(S state, In&& in) {
+            if(any && last == in)
+                return state;
+            last = in;
+            any = true;
+            return rf(std::move(state), std::forward<In>(in));
+        }
+        
+        bool done() const { return rf.done(); }
+        
+        template <typename S>
+        S complete(S state) { return rf.complete(std::move(state)); }
+    };
+    
+    template <typename T>
+    auto dedupe() {
+        return make_xform([](auto rf) { return dedupe_step<decltype(rf),T>{ std::move(rf), T{}, false }; });
+    }
+    
+    
+    
+    /// runs the step object over input until it is done, then completes it
+    template <typename RF, typename State, typename Range>
+    State reduce(RF& rf, State state, Range&& input) {
+        if(!rf.done()) {
+            for(auto&& x : input) {
+                state = rf(std::move(state), x);
+                if(rf.done())
+                    break;
+            }
+        }
+        return rf.complete(std::move(state));
+    }
+    
+    template <typename Make, typename Step, typename State, typename Range>
+    State transduce(const xform<Make>& xf, Step step, State init, Range&& input) {
+        auto rf = xf(completing<Step>{ std::move(step) });
+        return reduce(rf, std::move(init), std::forward<Range>(input));
+    }
+    
+}
 
 #endif /* defined(__hardware_control__transducers__) */
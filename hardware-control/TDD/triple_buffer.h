@@ -0,0 +1,46 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+/// Lock-free hand-over of the latest value from one producer thread to one
+/// consumer thread. The producer fills the back buffer and publishes it; the
+/// consumer picks up the most recently published buffer with update(). Neither
+/// side ever waits for the other, and values the consumer did not pick up in
+/// time are overwritten.
+template <typename T> class
+triple_buffer {
+    static constexpr uint8_t fresh = 4u;
+    static constexpr uint8_t index = 3u;
+    
+    T slots[3];
+    std::atomic<uint8_t> middle{1u};
+    uint8_t back = 0u;
+    uint8_t front = 2u;
+    
+public:
+    /// producer side: the buffer to fill
+    T& back_buffer() { return slots[back]; }
+    
+    /// producer side: makes the back buffer the latest one
+    void publish();
+    
+    /// consumer side: true if a newer buffer was picked up
+    bool update();
+    
+    /// consumer side: the buffer picked up last
+    T& front_buffer() { return slots[front]; }
+};
+
+
+template <typename T>
+void triple_buffer<T>::publish() {
+    back = middle.exchange(static_cast<uint8_t>(back | fresh), std::memory_order_acq_rel) & index;
+}
+
+template <typename T>
+bool triple_buffer<T>::update() {
+    if(!(middle.load(std::memory_order_relaxed) & fresh))
+        return false;
+    front = middle.exchange(front, std::memory_order_acq_rel) & index;
+    return true;
+}
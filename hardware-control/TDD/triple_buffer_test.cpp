@@ -0,0 +1,54 @@
+#include <TDD/triple_buffer.h>
+#include <catch.h>
+#include <atomic>
+#include <thread>
+
+SCENARIO("triple_buffer hands the latest value to the consumer","[triple_buffer]") {
+    GIVEN("a triple buffer") {
+        triple_buffer<int> buffer;
+        
+        WHEN("nothing was published") {
+            THEN("the consumer picks up nothing") {
+                REQUIRE(!buffer.update());
+            }
+        }
+        
+        WHEN("several values are published before the consumer looks") {
+            for(int i = 1; i <= 3; ++i) {
+                buffer.back_buffer() = i;
+                buffer.publish();
+            }
+            THEN("the consumer picks up the latest, once") {
+                REQUIRE(buffer.update());
+                REQUIRE(3 == buffer.front_buffer());
+                REQUIRE(!buffer.update());
+                REQUIRE(3 == buffer.front_buffer());
+            }
+        }
+        
+        WHEN("producer and consumer run concurrently") {
+            std::atomic<bool> done(false);
+            std::thread producer([&]{
+                for(int i = 1; i <= 100000; ++i) {
+                    buffer.back_buffer() = i;
+                    buffer.publish();
+                }
+                done = true;
+            });
+            int last = 0;
+            bool increasing = true;
+            while(!done || buffer.update()) {
+                if(buffer.update()) {
+                    increasing = increasing && buffer.front_buffer() > last;
+                    last = buffer.front_buffer();
+                }
+            }
+            producer.join();
+            buffer.update();
+            THEN("the consumer only sees newer values, ending with the last one") {
+                REQUIRE(increasing);
+                REQUIRE(100000 == buffer.front_buffer());
+            }
+        }
+    }
+}
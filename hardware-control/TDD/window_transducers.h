@@ -0,0 +1,381 @@
+#pragma once
+#include <TDD/transducers.h>
+#include <TDD/span.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/// Transducers for high-rate sample streams. Each takes single samples or
+/// chunks (span<const T>, e.g. from chunks()) and passes on doubles:
+///
+///     fixed_mean/min/max/rms<N>()    one value per N samples, a shorter rest is dropped
+///     sliding_mean/min/max/rms<N>()  one value per sample once N have arrived
+///     cic_decimate<Order>(R)         one value per R integer samples, gain normalized
+///     exp_smooth(alpha)              one value per sample
+///
+/// State is a fixed ring of N samples at most, and every sample costs O(1)
+/// amortized. Fixed windows reduce chunks of doubles with SSE2 where the
+/// target has it.
+
+namespace transducers {
+
+    namespace detail {
+        inline double block_sum(const double* x, size_t n) {
+            size_t i = 0u;
+            double s = 0.0;
+#if defined(__SSE2__)
+            __m128d a = _mm_setzero_pd(), b = _mm_setzero_pd();
+            for(; i + 4u <= n; i += 4u) {
+                a = _mm_add_pd(a, _mm_loadu_pd(x + i));
+                b = _mm_add_pd(b, _mm_loadu_pd(x + i + 2u));
+            }
+            double lanes[2];
+            _mm_storeu_pd(lanes, _mm_add_pd(a, b));
+            s = lanes[0] + lanes[1];
+#endif
+            for(; i < n; ++i)
+                s += x[i];
+            return s;
+        }
+
+        inline double block_sum_squares(const double* x, size_t n) {
+            size_t i = 0u;
+            double s = 0.0;
+#if defined(__SSE2__)
+            __m128d a = _mm_setzero_pd(), b = _mm_setzero_pd();
+            for(; i + 4u <= n; i += 4u) {
+                const __m128d u = _mm_loadu_pd(x + i), v = _mm_loadu_pd(x + i + 2u);
+                a = _mm_add_pd(a, _mm_mul_pd(u, u));
+                b = _mm_add_pd(b, _mm_mul_pd(v, v));
+            }
+            double lanes[2];
+            _mm_storeu_pd(lanes, _mm_add_pd(a, b));
+            s = lanes[0] + lanes[1];
+#endif
+            for(; i < n; ++i)
+                s += x[i] * x[i];
+            return s;
+        }
+
+        inline double block_min(const double* x, size_t n, double m) {
+            size_t i = 0u;
+#if defined(__SSE2__)
+            if(n >= 2u) {
+                __m128d a = _mm_set1_pd(m);
+                for(; i + 2u <= n; i += 2u)
+                    a = _mm_min_pd(a, _mm_loadu_pd(x + i));
+                double lanes[2];
+                _mm_storeu_pd(lanes, a);
+                m = std::min(lanes[0], lanes[1]);
+            }
+#endif
+            for(; i < n; ++i)
+                m = std::min(m, x[i]);
+            return m;
+        }
+
+        inline double block_max(const double* x, size_t n, double m) {
+            size_t i = 0u;
+#if defined(__SSE2__)
+            if(n >= 2u) {
+                __m128d a = _mm_set1_pd(m);
+                for(; i + 2u <= n; i += 2u)
+                    a = _mm_max_pd(a, _mm_loadu_pd(x + i));
+                double lanes[2];
+                _mm_storeu_pd(lanes, a);
+                m = std::max(lanes[0], lanes[1]);
+            }
+#endif
+            for(; i < n; ++i)
+                m = std::max(m, x[i]);
+            return m;
+        }
+
+        /// statistics of fixed windows; add() takes one sample, add_block() a run of them
+        struct mean_stat {
+            double sum = 0.0;
+            void add(double x) { sum += x; }
+            void add_block(const double* x, size_t n) { sum += block_sum(x, n); }
+            double value(size_t n) const { return sum / n; }
+        };
+
+        struct rms_stat {
+            double sum = 0.0;
+            void add(double x) { sum += x * x; }
+            void add_block(const double* x, size_t n) { sum += block_sum_squares(x, n); }
+            double value(size_t n) const { return std::sqrt(sum / n); }
+        };
+
+        struct min_stat {
+            double m = std::numeric_limits<double>::infinity();
+            void add(double x) { m = std::min(m, x); }
+            void add_block(const double* x, size_t n) { m = block_min(x, n, m); }
+            double value(size_t) const { return m; }
+        };
+
+        struct max_stat {
+            double m = -std::numeric_limits<double>::infinity();
+            void add(double x) { m = std::max(m, x); }
+            void add_block(const double* x, size_t n) { m = block_max(x, n, m); }
+            double value(size_t) const { return m; }
+        };
+
+        template <typename Stat, typename T>
+        void add_block(Stat& stat, const T* x, size_t n) {
+            for(size_t i = 0u; i < n; ++i)
+                stat.add(static_cast<double>(x[i]));
+        }
+
+        template <typename Stat>
+        void add_block(Stat& stat, const double* x, size_t n) {
+            stat.add_block(x, n);
+        }
+
+        /// feeds the samples of a chunk one by one, stopping as soon as rf is done
+        template <typename Step, typename S, typename T>
+        S each(Step& step, S state, span<const T> chunk) {
+            for(const T& x : chunk) {
+                state = step(std::move(state), x);
+                if(step.done())
+                    break;
+            }
+            return state;
+        }
+    }
+
+
+
+    template <typename RF, typename Stat, size_t N> struct
+    fixed_window_step {
+        RF rf;
+        Stat stat;
+        size_t count;
+
+        template <typename S, typename X, typename = std::enable_if_t<std::is_arithmetic<std::decay_t<X>>::value>>
+        S operator()(S state, X x) {
+            stat.add(static_cast<double>(x));
+            return ++count < N ? state : emit(std::move(state));
+        }
+
+        /// whole runs of a chunk go to the block kernels
+        template <typename S, typename T>
+        S operator()(S state, span<T> chunk) {
+            const T* x = chunk.data();
+            size_t left = chunk.size();
+            while(left != 0u && !rf.done()) {
+                const size_t n = std::min(left, N - count);
+                detail::add_block(stat, x, n);
+                x += n;
+                left -= n;
+                count += n;
+                if(count == N)
+                    state = emit(std::move(state));
+            }
+            return state;
+        }
+
+        bool done() const { return rf.done(); }
+
+        template <typename S>
+        S complete(S state) { return rf.complete(std::move(state)); }
+
+    private:
+        template <typename S>
+        S emit(S state) {
+            const double v = stat.value(N);
+            stat = Stat{};
+            count = 0u;
+            return rf(std::move(state), v);
+        }
+    };
+
+    template <typename Stat, size_t N>
+    auto fixed_window() {
+        static_assert(N > 0u, "windows need at least one sample");
+        return make_xform([](auto rf) { return fixed_window_step<decltype(rf),Stat,N>{ std::move(rf), Stat{}, 0u }; });
+    }
+
+    template <size_t N> auto fixed_mean() { return fixed_window<detail::mean_stat,N>(); }
+    template <size_t N> auto fixed_rms() { return fixed_window<detail::rms_stat,N>(); }
+    template <size_t N> auto fixed_min() { return fixed_window<detail::min_stat,N>(); }
+    template <size_t N> auto fixed_max() { return fixed_window<detail::max_stat,N>(); }
+
+
+
+    /// Running sum over the last N samples (squared for RMS). The sum is
+    /// recomputed from the ring every N samples so rounding errors of the
+    /// add/subtract updates cannot pile up.
+    template <typename RF, size_t N, bool Squares> struct
+    sliding_sum_step {
+        RF rf;
+        std::array<double,N> ring;
+        size_t next;
+        size_t filled;
+        double sum;
+
+        template <typename S, typename X, typename = std::enable_if_t<std::is_arithmetic<std::decay_t<X>>::value>>
+        S operator()(S state, X x) {
+            double v = static_cast<double>(x);
+            v = Squares ? v * v : v;
+            sum += v - ring[next];
+            ring[next] = v;
+            if(++next == N) {
+                next = 0u;
+                sum = detail::block_sum(ring.data(), N);
+            }
+            if(filled < N && ++filled < N)
+                return state;
+            return rf(std::move(state), Squares ? std::sqrt(std::max(sum, 0.0) / N) : sum / N);
+        }
+
+        template <typename S, typename T>
+        S operator()(S state, span<T> chunk) { return detail::each(*this, std::move(state), chunk); }
+
+        bool done() const { return rf.done(); }
+
+        template <typename S>
+        S complete(S state) { return rf.complete(std::move(state)); }
+    };
+
+    template <size_t N, bool Squares>
+    auto sliding_sum() {
+        static_assert(N > 0u, "windows need at least one sample");
+        return make_xform([](auto rf) { return sliding_sum_step<decltype(rf),N,Squares>{ std::move(rf), {}, 0u, 0u, 0.0 }; });
+    }
+
+    template <size_t N> auto sliding_mean() { return sliding_sum<N,false>(); }
+    template <size_t N> auto sliding_rms() { return sliding_sum<N,true>(); }
+
+    /// Minimum or maximum of the last N samples from a monotonic queue kept
+    /// in a ring of N entries: each sample is pushed and popped at most once.
+    template <typename RF, size_t N, typename Before> struct
+    sliding_extreme_step {
+        RF rf;
+        std::array<double,N> values;
+        std::array<size_t,N> positions;
+        size_t head;
+        size_t size;
+        size_t count;
+
+        template <typename S, typename X, typename = std::enable_if_t<std::is_arithmetic<std::decay_t<X>>::value>>
+        S operator()(S state, X x) {
+            const double v = static_cast<double>(x);
+            while(size != 0u && !Before{}(values[at(size - 1u)], v))
+                --size;
+            if(size != 0u && positions[head] + N <= count) {
+                head = at(1u);
+                --size;
+            }
+            values[at(size)] = v;
+            positions[at(size)] = count;
+            ++size;
+            if(++count < N)
+                return state;
+            return rf(std::move(state), values[head]);
+        }
+
+        template <typename S, typename T>
+        S operator()(S state, span<T> chunk) { return detail::each(*this, std::move(state), chunk); }
+
+        bool done() const { return rf.done(); }
+
+        template <typename S>
+        S complete(S state) { return rf.complete(std::move(state)); }
+
+    private:
+        size_t at(size_t i) const { return head + i < N ? head + i : head + i - N; }
+    };
+
+    template <size_t N, typename Before>
+    auto sliding_extreme() {
+        static_assert(N > 0u, "windows need at least one sample");
+        return make_xform([](auto rf) { return sliding_extreme_step<decltype(rf),N,Before>{ std::move(rf), {}, {}, 0u, 0u, 0u }; });
+    }
+
+    template <size_t N> auto sliding_min() { return sliding_extreme<N,std::less<double>>(); }
+    template <size_t N> auto sliding_max() { return sliding_extreme<N,std::greater<double>>(); }
+
+
+
+    /// Cascaded integrator-comb decimator with differential delay 1 for
+    /// integer samples. The integrators wrap around in 64 bit, which the
+    /// combs undo, so they never need to be reset. The output is divided by
+    /// the gain R^Order; the first Order outputs are the filter filling up.
+    template <typename RF, size_t Order> struct
+    cic_step {
+        RF rf;
+        size_t rate;
+        double gain;
+        size_t phase;
+        std::array<uint64_t,Order> integrators;
+        std::array<uint64_t,Order> delayed;
+
+        template <typename S, typename X, typename = std::enable_if_t<std::is_integral<std::decay_t<X>>::value>>
+        S operator()(S state, X x) {
+            uint64_t v = static_cast<uint64_t>(static_cast<int64_t>(x));
+            for(auto& integrator : integrators)
+                v = integrator += v;
+            if(++phase < rate)
+                return state;
+            phase = 0u;
+            for(auto& d : delayed) {
+                const uint64_t diff = v - d;
+                d = v;
+                v = diff;
+            }
+            return rf(std::move(state), static_cast<double>(static_cast<int64_t>(v)) / gain);
+        }
+
+        template <typename S, typename T>
+        S operator()(S state, span<T> chunk) { return detail::each(*this, std::move(state), chunk); }
+
+        bool done() const { return rf.done(); }
+
+        template <typename S>
+        S complete(S state) { return rf.complete(std::move(state)); }
+    };
+
+    template <size_t Order>
+    auto cic_decimate(size_t rate) {
+        static_assert(Order > 0u, "a CIC filter needs at least one stage");
+        const double gain = std::pow(static_cast<double>(rate), static_cast<double>(Order));
+        return make_xform([rate,gain](auto rf) { return cic_step<decltype(rf),Order>{ std::move(rf), rate, gain, 0u, {}, {} }; });
+    }
+
+    /// y += alpha * (x - y), starting at the first sample
+    template <typename RF> struct
+    exp_smooth_step {
+        RF rf;
+        double alpha;
+        double y;
+        bool started;
+
+        template <typename S, typename X, typename = std::enable_if_t<std::is_arithmetic<std::decay_t<X>>::value>>
+        S operator()(S state, X x) {
+            const double v = static_cast<double>(x);
+            y = started ? y + alpha * (v - y) : v;
+            started = true;
+            return rf(std::move(state), y);
+        }
+
+        template <typename S, typename T>
+        S operator()(S state, span<T> chunk) { return detail::each(*this, std::move(state), chunk); }
+
+        bool done() const { return rf.done(); }
+
+        template <typename S>
+        S complete(S state) { return rf.complete(std::move(state)); }
+    };
+
+    inline auto exp_smooth(double alpha) {
+        return make_xform([alpha](auto rf) { return exp_smooth_step<decltype(rf)>{ std::move(rf), alpha, 0.0, false }; });
+    }
+
+}
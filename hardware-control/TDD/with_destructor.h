@@ -2,6 +2,8 @@
 #include <map>
 #include <functional>
 #include <memory>
+#include <vector>
+#include <TDD/small_function.h>
 
 template <typename _Kty> struct
 with_destructor {
@@ -13,6 +15,8 @@ public:
 
     void remove_raii(_Kty key);
     
+    bool has_raii(const _Kty& key) const;
+    
     virtual ~with_destructor();
 };
 
@@ -28,6 +32,11 @@ void with_destructor<_Kty>::remove_raii(_Kty key) {
     functors.erase(std::move(key));
 }
 
+template <typename _Kty>
+bool with_destructor<_Kty>::has_raii(const _Kty& key) const {
+    return functors.count(key) != 0u;
+}
+
 template <typename _Kty>
 with_destructor<_Kty>::~with_destructor() {
     while(functors.size()) {
@@ -35,4 +44,130 @@ with_destructor<_Kty>::~with_destructor() {
         front->second();
         functors.erase(front->first);
     }
-}
\ No newline at end of file
+}
+
+/// Variant of with_destructor for objects that are registered in a few places
+/// only, e.g. listeners: the first N functors are stored in place, each in a
+/// small_function, so registration does not allocate. Removal swaps the last
+/// functor into the gap; the functors are called in unspecified order.
+template <typename _Kty, size_t N = 3> struct
+inline_with_destructor {
+    struct entry {
+        _Kty key;
+        small_function<void()> fun;
+    };
+    
+private:
+    entry inlined[N];
+    size_t count = 0u;
+    std::unique_ptr<std::vector<entry>> overflow;
+    
+    entry& at(size_t i);
+    
+    void erase_at(size_t i);
+    
+    size_t find(const _Kty& key) const;
+    
+public:
+    inline_with_destructor() = default;
+    
+    /// like intrusive hooks, copies start without functors; the registrations
+    /// belong to the original
+    inline_with_destructor(const inline_with_destructor&);
+    
+    inline_with_destructor& operator = (const inline_with_destructor&);
+    
+    template <typename Callable>
+    void add_raii(_Kty key, Callable fun);
+
+    void remove_raii(_Kty key);
+    
+    bool has_raii(const _Kty& key) const;
+    
+    /// runs and drops the functors now, e.g. from the destructor of a derived
+    /// class, while its members are still alive
+    void run_raii();
+    
+    virtual ~inline_with_destructor();
+};
+
+
+template <typename _Kty, size_t N>
+inline_with_destructor<_Kty,N>::inline_with_destructor(const inline_with_destructor&)
+{
+}
+
+template <typename _Kty, size_t N>
+inline_with_destructor<_Kty,N>& inline_with_destructor<_Kty,N>::operator = (const inline_with_destructor&) {
+    return *this;
+}
+
+template <typename _Kty, size_t N>
+typename inline_with_destructor<_Kty,N>::entry& inline_with_destructor<_Kty,N>::at(size_t i) {
+    return i < N ? inlined[i] : (*overflow)[i - N];
+}
+
+template <typename _Kty, size_t N>
+void inline_with_destructor<_Kty,N>::erase_at(size_t i) {
+    const size_t last = count - 1u;
+    if(i != last)
+        at(i) = std::move(at(last));
+    if(last < N)
+        inlined[last].fun = {};
+    else
+        overflow->pop_back();
+    count = last;
+}
+
+template <typename _Kty, size_t N>
+size_t inline_with_destructor<_Kty,N>::find(const _Kty& key) const {
+    auto self = const_cast<inline_with_destructor*>(this);
+    for(size_t i = 0u; i < count; ++i)
+        if(self->at(i).key == key)
+            return i;
+    return count;
+}
+
+template <typename _Kty, size_t N>
+template <typename Callable>
+void inline_with_destructor<_Kty,N>::add_raii(_Kty key, Callable fun) {
+    const size_t i = find(key);
+    if(i < count) {
+        at(i).fun = std::move(fun);
+        return;
+    }
+    if(count < N)
+        inlined[count] = entry{ std::move(key), std::move(fun) };
+    else {
+        if(!overflow)
+            overflow.reset(new std::vector<entry>);
+        overflow->push_back(entry{ std::move(key), std::move(fun) });
+    }
+    ++count;
+}
+
+template <typename _Kty, size_t N>
+void inline_with_destructor<_Kty,N>::remove_raii(_Kty key) {
+    const size_t i = find(key);
+    if(i < count)
+        erase_at(i);
+}
+
+template <typename _Kty, size_t N>
+bool inline_with_destructor<_Kty,N>::has_raii(const _Kty& key) const {
+    return find(key) < count;
+}
+
+template <typename _Kty, size_t N>
+void inline_with_destructor<_Kty,N>::run_raii() {
+    while(count) {
+        auto fun = std::move(at(0).fun);
+        erase_at(0);
+        fun();
+    }
+}
+
+template <typename _Kty, size_t N>
+inline_with_destructor<_Kty,N>::~inline_with_destructor() {
+    run_raii();
+}
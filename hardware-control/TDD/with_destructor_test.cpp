@@ -1,5 +1,6 @@
 #include <TDD/with_destructor.h>
 #include <catch.h>
+#include <array>
 
 
 TEST_CASE("with_destructor::add_raii","[with_destructor]") {
@@ -81,3 +82,109 @@ TEST_CASE("with_destructor::remove_raii","[with_destructor]") {
         }
     }
 }
+
+
+TEST_CASE("inline_with_destructor","[with_destructor]") {
+    GIVEN("an instance of inline_with_destructor with room for two functors") {
+        auto wd = new inline_with_destructor<int,2>();
+        
+        WHEN("more functors are added than fit in place, and some are removed") {
+            int called[5] = {};
+            for(int i = 0; i < 5; ++i)
+                wd->add_raii(i,[&called,i]{ ++called[i]; });
+            wd->remove_raii(0);
+            wd->remove_raii(3);
+            THEN("exactly the remaining functors are called once on destruction") {
+                REQUIRE(!wd->has_raii(0));
+                REQUIRE(wd->has_raii(4));
+                delete wd;
+                REQUIRE(0 == called[0]);
+                REQUIRE(1 == called[1]);
+                REQUIRE(1 == called[2]);
+                REQUIRE(0 == called[3]);
+                REQUIRE(1 == called[4]);
+            }
+        }
+        
+        WHEN("A functor is added that will call remove_raii()") {
+            bool called1 = false, called2 = false;
+            wd->add_raii(1,[&called1,wd]{
+                called1 = true;
+                wd->remove_raii(2);
+            });
+            wd->add_raii(2,[&called2]{ called2 = true; });
+            THEN("the functor removed by the first is not called") {
+                delete wd;
+                REQUIRE(called1);
+                REQUIRE(!called2);
+            }
+        }
+        
+        WHEN("A functor is added that will call add_raii()") {
+            bool called1 = false, called2 = false;
+            wd->add_raii(1,[&called1,&called2,wd]{
+                called1 = true;
+                wd->add_raii(2,[&called2]{ called2 = true; });
+            });
+            THEN("the functor added by the first is called as well") {
+                delete wd;
+                REQUIRE(called1);
+                REQUIRE(called2);
+            }
+        }
+        
+        WHEN("the functors are run before destruction") {
+            int called = 0;
+            wd->add_raii(1,[&called]{ ++called; });
+            wd->add_raii(2,[&called]{ ++called; });
+            wd->run_raii();
+            THEN("each runs once and destruction calls none of them again") {
+                REQUIRE(2 == called);
+                REQUIRE(!wd->has_raii(1));
+                delete wd;
+                REQUIRE(2 == called);
+            }
+        }
+        
+        WHEN("a functor is added twice under the same key") {
+            int first = 0, second = 0;
+            wd->add_raii(7,[&first]{ ++first; });
+            wd->add_raii(7,[&second]{ ++second; });
+            THEN("the second one replaces the first") {
+                delete wd;
+                REQUIRE(0 == first);
+                REQUIRE(1 == second);
+            }
+        }
+    }
+}
+
+
+TEST_CASE("small_function","[with_destructor]") {
+    GIVEN("a callable capturing two pointers") {
+        int a = 1, b = 2;
+        small_function<int()> f([&a,&b]{ return a + b; });
+        THEN("it is called like a std::function, also through copies and moves") {
+            REQUIRE(3 == f());
+            auto copy = f;
+            auto moved = std::move(f);
+            REQUIRE(!f);
+            REQUIRE(3 == copy());
+            REQUIRE(3 == moved());
+        }
+    }
+    
+    GIVEN("a callable too large to be stored in place") {
+        std::array<int,16> values{};
+        values[15] = 42;
+        small_function<int(int)> f([values](int i){ return values[i]; });
+        THEN("it is stored on the heap and behaves the same") {
+            REQUIRE(42 == f(15));
+            small_function<int(int)> g;
+            g = f;
+            f = {};
+            REQUIRE(!f);
+            REQUIRE(42 == g(15));
+        }
+    }
+}
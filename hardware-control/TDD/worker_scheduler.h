@@ -0,0 +1,88 @@
+#pragma once
+#include <TDD/ischeduler.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/// Scheduler running all tasks on one worker thread in the order they were
+/// scheduled. Scheduling only queues the task; it never runs it inline.
+/// Tasks still pending on destruction are run before the worker exits.
+template <typename TaskId> class
+worker_scheduler final : public ischeduler<TaskId> {
+    std::mutex mutex;
+    std::condition_variable wake, idle;
+    std::deque<std::pair<TaskId,std::function<void()>>> tasks;
+    const TaskId* running = nullptr;
+    bool stopping = false;
+    std::thread worker;
+    
+    void schedule_impl(TaskId task_id, std::function<void()> f) override;
+    
+    void unschedule_impl(TaskId task_id) override;
+    
+    void run();
+    
+public:
+    worker_scheduler();
+    
+    worker_scheduler(const worker_scheduler&) = delete;
+    
+    ~worker_scheduler();
+};
+
+
+template <typename TaskId>
+worker_scheduler<TaskId>::worker_scheduler()
+    : worker([this]{ run(); })
+{
+}
+
+template <typename TaskId>
+worker_scheduler<TaskId>::~worker_scheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+template <typename TaskId>
+void worker_scheduler<TaskId>::schedule_impl(TaskId task_id, std::function<void()> f) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.emplace_back(std::move(task_id), std::move(f));
+    }
+    wake.notify_one();
+}
+
+/// Called from a task of the same id, the running task is not waited for.
+template <typename TaskId>
+void worker_scheduler<TaskId>::unschedule_impl(TaskId task_id) {
+    std::unique_lock<std::mutex> lock(mutex);
+    tasks.erase(std::remove_if(tasks.begin(), tasks.end(), [&](const std::pair<TaskId,std::function<void()>>& task){
+        return task.first == task_id;
+    }), tasks.end());
+    if(std::this_thread::get_id() != worker.get_id())
+        idle.wait(lock, [&]{ return !running || !(*running == task_id); });
+}
+
+template <typename TaskId>
+void worker_scheduler<TaskId>::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for(;;) {
+        wake.wait(lock, [this]{ return stopping || !tasks.empty(); });
+        if(tasks.empty())
+            return;
+        auto task = std::move(tasks.front());
+        tasks.pop_front();
+        running = &task.first;
+        lock.unlock();
+        task.second();
+        lock.lock();
+        running = nullptr;
+        idle.notify_all();
+    }
+}
@@ -1,6 +1,7 @@
 #include "../catch.h"
 #include <Framework/Any.h>
 #include <string>
+#include <memory>
 
 TEST_CASE( "Anything be stored into an Any", "[any]" ) {
     REQUIRE( Any(1).as<int>() == 1 );
@@ -17,4 +18,21 @@ TEST_CASE( "Anything be stored into an Any", "[any]" ) {
             REQUIRE_THROWS_AS(any_int.as_s<double>(), std::bad_cast);
         }
     }
-}
\ No newline at end of file
+}
+TEST_CASE( "Move-only values can be stored into an Any", "[any]" ) {
+    Any any_ptr(std::unique_ptr<int>(new int(42)));
+    
+    WHEN("the value is moved out of the Any") {
+        auto ptr = std::move(any_ptr.as<std::unique_ptr<int>>());
+        THEN("it is handed on without copying") {
+            REQUIRE(*ptr == 42);
+            REQUIRE(!any_ptr.as<std::unique_ptr<int>>());
+        }
+    }
+    
+    WHEN("the Any is copied") {
+        THEN("copying throws") {
+            REQUIRE_THROWS_AS(Any{any_ptr}, std::bad_cast);
+        }
+    }
+}
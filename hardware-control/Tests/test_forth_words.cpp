@@ -0,0 +1,221 @@
+#include "../catch.h"
+
+#include <iostream>
+#include <HAL/MotorCtrl/Implementation/CanOpenDS402MotorCtrl.h>
+#include <HAL/MotorCtrl/Implementation/ElmoWhistleMotorCtrl.h>
+#include <HAL/CameraCtrl/Implementation/CmosOV3642.h>
+#include <HAL/CameraCtrl/Implementation/CmosOV8825.h>
+#include <HAL/CameraCtrl/Implementation/SyntheticCamera.h>
+#include <HAL/Scripting/ForthWords.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace {
+    /// the commands that reached the devices, as the controllers log them to
+    /// std::cout; the stream is formatted as by default while it is captured
+    struct device_log {
+        std::ostringstream out;
+        std::streambuf* const saved;
+        std::ios format { nullptr };
+        
+        device_log() : saved(std::cout.rdbuf(out.rdbuf())) {
+            format.copyfmt(std::cout);
+            std::cout.copyfmt(std::ios(nullptr));
+        }
+        
+        ~device_log() {
+            std::cout.copyfmt(format);
+            std::cout.rdbuf(saved);
+        }
+        
+        std::vector<std::string> lines() {
+            std::vector<std::string> result;
+            std::istringstream in(out.str());
+            for(std::string line; std::getline(in, line); )
+                result.push_back(line);
+            out.str("");
+            return result;
+        }
+    };
+    
+    using trace = std::vector<std::string>;
+    
+    /// a motor that cannot move beyond its end stop, for batches that fail
+    struct limited_motor {
+        int limit;
+        trace moves;
+    };
+}
+
+template <> struct
+visit<limited_motor,Motor::MoveToAbs> {
+    static int call(limited_motor& m, Motor::MoveToAbs& cmd) {
+        m.moves.push_back("MoveToAbs(" + std::to_string(cmd.steps) + ")");
+        return cmd.steps > m.limit ? -1 : 0;
+    }
+};
+
+template <> struct
+visit<limited_motor,Motor::MoveToRel> {
+    static int call(limited_motor& m, Motor::MoveToRel& cmd) {
+        m.moves.push_back("MoveToRel(" + std::to_string(cmd.steps) + ")");
+        return 0;
+    }
+};
+
+template <> struct
+visit<limited_motor,Motor::RunVelocity> {
+    static int call(limited_motor& m, Motor::RunVelocity&) {
+        m.moves.push_back("RunVelocity");
+        return 0;
+    }
+};
+
+template <> struct
+visit<limited_motor,Motor::FindHome> {
+    static int call(limited_motor& m, Motor::FindHome&) {
+        m.moves.push_back("FindHome()");
+        return 0;
+    }
+};
+
+
+SCENARIO("a motor batch stops at the first failing command","[forth]") {
+    GIVEN("a batch whose second move exceeds the motor's travel") {
+        limited_motor motor { 1000, {} };
+        Motor::Batch batch;
+        batch.findHome();
+        batch.moveToAbs(2000);
+        batch.moveToRel(5);
+        batch.runVelocity(10.0);
+        
+        WHEN("it is run") {
+            const auto results = Motor::runBatch(motor, batch);
+            THEN("the commands after the failing one are not run") {
+                REQUIRE(results == (std::vector<int>{ 0, -1 }));
+                REQUIRE(motor.moves == (trace{ "FindHome()", "MoveToAbs(2000)" }));
+            }
+        }
+    }
+}
+
+
+SCENARIO("scan recipes drive motors and cameras from Forth","[forth]") {
+    GIVEN("a pan motor, a mirror motor and a camera bound to Forth words") {
+        device_log log;
+        forth::machine vm;
+        device_words words(vm);
+        std::vector<picture> pictures;
+        words.bind("pan.", std::make_shared<CanOpenDS402MotorCtrl>());
+        words.bind("mirror.", std::make_shared<ElmoWhistleMotorCtrl>());
+        words.bind("cam.", std::make_shared<SyntheticCamera>(frame_format{ 64u, 48u }), [&pictures](picture pic) {
+            std::cout << "picture " << pic.sequence() << std::endl;
+            pictures.push_back(std::move(pic));
+        });
+        
+        WHEN("a recipe moves one motor several times") {
+            words.interpret("pan.find-home 100 pan.move-abs 5 pan.move-rel 1000 pan.run-velocity");
+            THEN("the moves are submitted together") {
+                REQUIRE(words.submissions() == 1u);
+                REQUIRE(log.lines() == (trace{
+                    "CanOpenDS402MotorCtrl: Batch(4)",
+                    "CanOpenDS402MotorCtrl: FindHome()",
+                    "CanOpenDS402MotorCtrl: MoveToAbs(100)",
+                    "CanOpenDS402MotorCtrl: MoveToRel(5)",
+                    "CanOpenDS402MotorCtrl: RunVelocity(1000)"
+                }));
+            }
+        }
+        WHEN("a recipe alternates between devices") {
+            words.interpret("pan.find-home mirror.find-home 10 pan.move-rel");
+            THEN("every change of device is a submission") {
+                REQUIRE(words.submissions() == 3u);
+                REQUIRE(log.lines() == (trace{
+                    "CanOpenDS402MotorCtrl: Batch(1)",
+                    "CanOpenDS402MotorCtrl: FindHome()",
+                    "ElmoWhistleMotorCtrl: Batch(1)",
+                    "ElmoWhistleMotorCtrl: FindHome()",
+                    "CanOpenDS402MotorCtrl: Batch(1)",
+                    "CanOpenDS402MotorCtrl: MoveToRel(10)"
+                }));
+            }
+        }
+        WHEN("a recipe takes several pictures in a row") {
+            words.interpret(": burst 0 do cam.take-picture loop ; 2 burst");
+            THEN("they are taken in one submission") {
+                REQUIRE(words.submissions() == 1u);
+                REQUIRE(log.lines() == (trace{ "picture 0", "picture 1" }));
+                REQUIRE(pictures.size() == 2u);
+                REQUIRE(pictures[0].format().width == 64u);
+                REQUIRE(pictures[0].format().height == 48u);
+                REQUIRE(pictures[1].data()[0] == SyntheticCamera::testPattern(0u, 0u, 1u));
+            }
+        }
+        WHEN("a recipe keeps more pictures than the camera has buffers") {
+            REQUIRE_THROWS_AS(words.interpret(": burst 0 do cam.take-picture loop ; 4 burst"), forth::error);
+            THEN("the batch fails once the buffers run out instead of waiting for one") {
+                REQUIRE(words.submissions() == 1u);
+                REQUIRE(pictures.size() == 3u);
+                REQUIRE(log.lines() == (trace{ "picture 0", "picture 1", "picture 2" }));
+            }
+        }
+        WHEN("a scan steps the mirror and takes a picture at each position") {
+            const auto scan = vm.compile(": step 10 * mirror.move-abs cam.take-picture ; 3 0 do i step loop");
+            words.run(scan);
+            THEN("motion and capture keep their order") {
+                REQUIRE(words.submissions() == 6u);
+                REQUIRE(pictures.size() == 3u);
+                REQUIRE(log.lines() == (trace{
+                    "ElmoWhistleMotorCtrl: Batch(1)",
+                    "ElmoWhistleMotorCtrl: MoveToAbs(0)",
+                    "picture 0",
+                    "ElmoWhistleMotorCtrl: Batch(1)",
+                    "ElmoWhistleMotorCtrl: MoveToAbs(10)",
+                    "picture 1",
+                    "ElmoWhistleMotorCtrl: Batch(1)",
+                    "ElmoWhistleMotorCtrl: MoveToAbs(20)",
+                    "picture 2"
+                }));
+            }
+        }
+        WHEN("a recipe synchronizes explicitly") {
+            words.interpret("1 pan.move-abs sync 2 pan.move-abs");
+            THEN("sync ends the batch") {
+                REQUIRE(words.submissions() == 2u);
+                REQUIRE(log.lines() == (trace{
+                    "CanOpenDS402MotorCtrl: Batch(1)",
+                    "CanOpenDS402MotorCtrl: MoveToAbs(1)",
+                    "CanOpenDS402MotorCtrl: Batch(1)",
+                    "CanOpenDS402MotorCtrl: MoveToAbs(2)"
+                }));
+            }
+        }
+        WHEN("recipes are interpreted over and over") {
+            words.interpret(": home pan.find-home ;");
+            const size_t size = vm.code_size();
+            for(int i = 0; i < 100; ++i)
+                words.interpret("home");
+            THEN("their top-level code is not kept") {
+                REQUIRE(words.submissions() == 100u);
+                REQUIRE(vm.code_size() == size);
+            }
+        }
+        WHEN("a recipe fails") {
+            REQUIRE_THROWS_AS(words.interpret("1 pan.move-abs pan.move-abs"), forth::error);
+            THEN("what it queued is not submitted") {
+                REQUIRE(words.submissions() == 0u);
+                REQUIRE(log.lines().empty());
+                words.interpret("pan.find-home");
+                REQUIRE(words.submissions() == 1u);
+                REQUIRE(log.lines() == (trace{
+                    "CanOpenDS402MotorCtrl: Batch(1)",
+                    "CanOpenDS402MotorCtrl: FindHome()"
+                }));
+            }
+        }
+    }
+}
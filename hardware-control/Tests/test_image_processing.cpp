@@ -0,0 +1,137 @@
+#include "../catch.h"
+
+#include <HAL/CameraCtrl/Processing/ImageProcessing.h>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <random>
+#include <vector>
+
+namespace {
+    image randomImage(size_t width, size_t height, size_t channels) {
+        image img(width, height, channels);
+        std::mt19937 rng(42);
+        for(auto& p : img.pixels)
+            p = static_cast<uint8_t>(rng());
+        return img;
+    }
+    
+    /// frame whose Bayer sites show a uniform color
+    picture uniformBayer(frame_pool& pool, uint8_t r, uint8_t g, uint8_t b) {
+        auto raw = pool.acquire();
+        const auto& fmt = raw.format();
+        for(size_t y = 0u; y < fmt.height; ++y)
+            for(size_t x = 0u; x < fmt.width; ++x)
+                raw.data()[y * fmt.width + x] = (y % 2 == 0) ? (x % 2 == 0 ? r : g) : (x % 2 == 0 ? g : b);
+        return raw;
+    }
+}
+
+
+SCENARIO("all instruction sets give identical results","[processing]") {
+    const auto initial = Processing::activeIsa();
+    // odd sizes exercise the scalar tails of the vector loops
+    const auto rgb = randomImage(203u, 67u, 3u);
+    
+    auto pool = frame_pool::create({ 203u, 67u }, 1u);
+    auto raw = pool->acquire();
+    const auto bayer = randomImage(203u, 67u, 1u);
+    std::copy(bayer.pixels.begin(), bayer.pixels.end(), raw.data());
+    
+    Processing::selectIsa(Processing::Isa::Scalar);
+    REQUIRE(Processing::Isa::Scalar == Processing::activeIsa());
+    const auto grayScalar = Processing::toGray(rgb);
+    const auto halfScalar = Processing::downscale(rgb, 2u);
+    const auto quarterScalar = Processing::downscale(rgb, 4u);
+    const auto demosaicScalar = Processing::demosaic(raw);
+    
+    for(auto isa : { Processing::Isa::SSE2, Processing::Isa::AVX2 }) {
+        const auto selected = Processing::selectIsa(isa);
+        INFO("selected instruction set " << static_cast<int>(selected));
+        REQUIRE(grayScalar->pixels == Processing::toGray(rgb)->pixels);
+        REQUIRE(halfScalar->pixels == Processing::downscale(rgb, 2u)->pixels);
+        REQUIRE(quarterScalar->pixels == Processing::downscale(rgb, 4u)->pixels);
+        REQUIRE(demosaicScalar->pixels == Processing::demosaic(raw)->pixels);
+    }
+    Processing::selectIsa(initial);
+    
+    THEN("the results have the expected geometry and values") {
+        // a green site of a blue row: red from above and below, blue from left and right
+        const size_t x = 100u, y = 33u, w = 203u;
+        const uint8_t* p = bayer.pixels.data();
+        REQUIRE(static_cast<uint8_t>((p[(y-1)*w + x] + p[(y+1)*w + x] + 1u) / 2u) == demosaicScalar->plane(0)[y*w + x]);
+        REQUIRE(p[y*w + x] == demosaicScalar->plane(1)[y*w + x]);
+        REQUIRE(static_cast<uint8_t>((p[y*w + x-1] + p[y*w + x+1] + 1u) / 2u) == demosaicScalar->plane(2)[y*w + x]);
+        REQUIRE(101u == halfScalar->width);
+        REQUIRE(33u == halfScalar->height);
+        REQUIRE(3u == halfScalar->channels);
+        REQUIRE(50u == quarterScalar->width);
+        const uint8_t expected = static_cast<uint8_t>((77u * rgb.plane(0)[5] + 150u * rgb.plane(1)[5] + 29u * rgb.plane(2)[5]) >> 8);
+        REQUIRE(expected == grayScalar->pixels[5]);
+    }
+}
+
+
+SCENARIO("frames are pre-processed","[processing]") {
+    auto pool = frame_pool::create(frame_format{ 64u, 32u }, 1u);
+    
+    GIVEN("a Bayer frame of a uniform color") {
+        auto raw = uniformBayer(*pool, 200u, 100u, 50u);
+        
+        WHEN("it is demosaiced") {
+            auto rgb = Processing::demosaic(raw);
+            THEN("every pixel has that color") {
+                REQUIRE(3u == rgb->channels);
+                for(size_t i = 0u; i < rgb->width * rgb->height; ++i) {
+                    REQUIRE(200u == rgb->plane(0)[i]);
+                    REQUIRE(100u == rgb->plane(1)[i]);
+                    REQUIRE(50u == rgb->plane(2)[i]);
+                }
+            }
+        }
+        
+        WHEN("its histogram is taken") {
+            auto hist = Processing::histogram(raw);
+            THEN("it counts the Bayer sites of each color") {
+                REQUIRE(64u * 32u / 4u == hist[200]);
+                REQUIRE(64u * 32u / 2u == hist[100]);
+                REQUIRE(64u * 32u / 4u == hist[50]);
+            }
+        }
+        
+        WHEN("a region is cropped from it") {
+            auto cropped = Processing::crop(raw, roi{ 3u, 5u, 10u, 4u });
+            THEN("the region is widened to even coordinates") {
+                REQUIRE(12u == cropped->width);
+                REQUIRE(6u == cropped->height);
+                REQUIRE(200u == cropped->plane(0)[0]);
+                REQUIRE(50u == cropped->plane(0)[cropped->width + 1u]);
+            }
+        }
+    }
+    
+    GIVEN("an RGB image") {
+        const auto rgb = randomImage(16u, 8u, 3u);
+        WHEN("a region is cropped from it") {
+            auto cropped = Processing::crop(rgb, roi{ 2u, 3u, 5u, 4u });
+            THEN("every plane holds the pixels of the region") {
+                REQUIRE(rgb.plane(2)[3u * 16u + 2u] == cropped->plane(2)[0]);
+                REQUIRE(rgb.plane(1)[6u * 16u + 6u] == cropped->plane(1)[3u * 5u + 4u]);
+            }
+        }
+    }
+}
+
+
+SCENARIO("frames too small to demosaic are rejected","[processing]") {
+    for(auto fmt : { frame_format{ 1u, 8u }, frame_format{ 8u, 1u } }) {
+        auto pool = frame_pool::create(fmt, 1u);
+        auto raw = pool->acquire();
+        REQUIRE_THROWS_AS(Processing::demosaic(raw), std::invalid_argument);
+    }
+    auto pool = frame_pool::create({ 2u, 2u }, 1u);
+    auto raw = uniformBayer(*pool, 10u, 20u, 30u);
+    const auto rgb = Processing::demosaic(raw);
+    REQUIRE(std::vector<uint8_t>(4u, 10u) == std::vector<uint8_t>(rgb->plane(0), rgb->plane(0) + 4));
+    REQUIRE(std::vector<uint8_t>(4u, 30u) == std::vector<uint8_t>(rgb->plane(2), rgb->plane(2) + 4));
+}
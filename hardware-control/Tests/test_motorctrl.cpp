@@ -13,6 +13,7 @@
 
 #include <HAL/CameraCtrl/Implementation/CmosOV3642.h>
 #include <HAL/CameraCtrl/Implementation/CmosOV8825.h>
+#include <HAL/CameraCtrl/Implementation/SyntheticCamera.h>
 #include <HAL/CameraCtrl/Commands/Initialize.h>
 #include <HAL/CameraCtrl/Commands/TakePicture.h>
 
@@ -0,0 +1,223 @@
+#include "../catch.h"
+
+#include <iostream>
+#include <HAL/CameraCtrl/Implementation/CmosOV3642.h>
+#include <HAL/CameraCtrl/Implementation/CmosOV8825.h>
+#include <HAL/CameraCtrl/Implementation/SyntheticCamera.h>
+#include <HAL/CameraCtrl/Commands/TakePicture.h>
+#include <HAL/CameraCtrl/Commands/Stream.h>
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <type_traits>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <TDD/listener.h>
+
+static_assert(!std::is_copy_constructible<picture>::value, "pictures must not be copied");
+static_assert(std::is_nothrow_move_constructible<picture>::value, "pictures are handed on by moving");
+
+
+SCENARIO("frame buffers are pooled","[picture]") {
+    GIVEN("a pool of two buffers") {
+        auto pool = frame_pool::create(frame_format{ 640u, 480u }, 2u);
+        
+        WHEN("pictures are acquired") {
+            auto a = pool->acquire();
+            auto b = pool->acquire();
+            THEN("they refer to distinct, page-aligned buffers of the frame size") {
+                REQUIRE(a);
+                REQUIRE(b);
+                REQUIRE(a.data() != b.data());
+                REQUIRE(640u * 480u == a.size());
+                REQUIRE(0u == reinterpret_cast<uintptr_t>(a.data()) % frame_pool::page_size());
+                REQUIRE(0u == reinterpret_cast<uintptr_t>(b.data()) % frame_pool::page_size());
+            }
+            AND_THEN("the pool is exhausted until one of them is released") {
+                REQUIRE(!pool->try_acquire());
+                const auto pixels = a.data();
+                a = picture();
+                auto c = pool->try_acquire();
+                REQUIRE(c);
+                REQUIRE(pixels == c.data());
+            }
+        }
+        
+        WHEN("a picture is moved") {
+            auto a = pool->acquire();
+            const auto pixels = a.data();
+            auto b = std::move(a);
+            THEN("the buffer is handed on without copying") {
+                REQUIRE(!a);
+                REQUIRE(pixels == b.data());
+                REQUIRE(1u == pool->free_count());
+            }
+        }
+        
+        WHEN("the pool is dropped while a picture is alive") {
+            auto a = pool->acquire();
+            a.data()[0] = 42;
+            std::weak_ptr<frame_pool> weak = pool;
+            pool = nullptr;
+            THEN("the picture keeps the pool alive until it is released") {
+                REQUIRE(!weak.expired());
+                REQUIRE(42 == a.data()[0]);
+                a = picture();
+                REQUIRE(weak.expired());
+            }
+        }
+    }
+}
+
+
+SCENARIO("cameras fill pooled pictures in place","[picture]") {
+    GIVEN("a camera behind the ICameraCtrl interface") {
+        auto camera = std::make_shared<CmosOV3642>();
+        std::shared_ptr<ICameraCtrl> cam = camera;
+        Camera::TakePicture takePicture;
+        
+        WHEN("pictures are taken") {
+            auto first = cam->accept(takePicture);
+            auto second = cam->accept(takePicture);
+            THEN("they are buffers of the camera's pool, with the sensor's format") {
+                REQUIRE(CmosOV3642::format().bytes() == first.size());
+                REQUIRE(camera->frames().capacity() - 2u == camera->frames().free_count());
+                REQUIRE(0u == first.sequence());
+                REQUIRE(1u == second.sequence());
+            }
+            AND_THEN("releasing them returns the buffers to the pool for the next frames") {
+                std::set<const uint8_t*> buffers{ first.data(), second.data() };
+                first = picture();
+                second = picture();
+                for(int i = 0; i < 5; ++i) {
+                    auto pic = cam->accept(takePicture);
+                    buffers.insert(pic.data());
+                }
+                REQUIRE(buffers.size() <= camera->frames().capacity());
+                REQUIRE(camera->frames().capacity() == camera->frames().free_count());
+            }
+        }
+        WHEN("the caller holds every picture of the pool") {
+            std::vector<picture> held;
+            while(camera->frames().free_count() != 0u)
+                held.push_back(cam->accept(takePicture));
+            THEN("taking one more fails instead of waiting for a buffer") {
+                REQUIRE_THROWS_AS(cam->accept(takePicture), Camera::error);
+                held.pop_back();
+                REQUIRE(cam->accept(takePicture).sequence() == held.size() + 1u);
+            }
+        }
+    }
+}
+
+
+SCENARIO("cameras stream frames continuously","[picture][stream]") {
+    GIVEN("a synthetic camera streaming at a high rate") {
+        auto camera = std::make_shared<SyntheticCamera>(frame_format{ 64u, 48u });
+        std::shared_ptr<ICameraCtrl> cam = camera;
+        Camera::StartStream start(1000.0);
+        auto stream = cam->accept(start);
+        REQUIRE(stream);
+        
+        WHEN("the latest frame is polled") {
+            std::shared_ptr<const picture> frame;
+            while(!(frame = stream->latest()))
+                std::this_thread::yield();
+            THEN("it is a complete frame of the camera") {
+                REQUIRE(64u * 48u == frame->size());
+                const uint8_t expected = static_cast<uint8_t>(63u + 47u + frame->sequence());
+                REQUIRE(expected == frame->data()[frame->size() - 1u]);
+            }
+            AND_THEN("later polls return newer frames") {
+                std::shared_ptr<const picture> next;
+                do {
+                    std::this_thread::yield();
+                    next = stream->latest();
+                } while(next == frame);
+                REQUIRE(next->sequence() > frame->sequence());
+            }
+        }
+        
+        WHEN("a listener subscribes to the frames") {
+            std::mutex mutex;
+            std::condition_variable received;
+            std::vector<uint64_t> sequences;
+            listener<std::shared_ptr<const picture>> l([&](std::shared_ptr<const picture>&& frame){
+                std::lock_guard<std::mutex> lock(mutex);
+                sequences.push_back(frame->sequence());
+                received.notify_one();
+            });
+            stream->frames().registerListener(l);
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                received.wait(lock, [&]{ return sequences.size() >= 5u; });
+            }
+            stream->frames().unregisterListener(l);
+            THEN("it is called with every captured frame in order") {
+                std::lock_guard<std::mutex> lock(mutex);
+                for(size_t i = 1u; i < sequences.size(); ++i)
+                    REQUIRE(sequences[i-1] < sequences[i]);
+            }
+        }
+        
+        WHEN("consumers hold on to all frames") {
+            std::vector<std::shared_ptr<const picture>> held;
+            while(stream->dropped() == 0u) {
+                if(auto frame = stream->latest())
+                    if(held.empty() || held.back() != frame)
+                        held.push_back(frame);
+                std::this_thread::yield();
+            }
+            THEN("the stream drops frames instead of blocking") {
+                REQUIRE(held.size() <= start.buffers);
+                REQUIRE(stream->captured() >= held.size());
+            }
+        }
+        
+        WHEN("the stream is stopped") {
+            Camera::StopStream stop;
+            REQUIRE(cam->accept(stop));
+            const auto captured = stream->captured();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            THEN("no further frames are captured") {
+                REQUIRE(captured == stream->captured());
+                REQUIRE(!cam->accept(stop));
+            }
+        }
+        
+        WHEN("a subscriber stops the stream the camera holds the last reference to") {
+            std::weak_ptr<frame_stream> weak = stream;
+            iobservable<std::shared_ptr<const picture>>& frames = stream->frames();
+            stream = nullptr;
+            std::promise<bool> stopped;
+            std::unique_ptr<listener<std::shared_ptr<const picture>>> l;
+            l.reset(new listener<std::shared_ptr<const picture>>([&](const std::shared_ptr<const picture>&){
+                frames.unregisterListener(*l);
+                Camera::StopStream stop;
+                stopped.set_value(cam->accept(stop));
+            }));
+            frames.registerListener(*l);
+            THEN("the stream is destroyed on the capture thread, which exits on its own") {
+                REQUIRE(stopped.get_future().get());
+                REQUIRE(weak.expired());
+            }
+        }
+        
+        WHEN("the camera is destroyed while it streams") {
+            std::weak_ptr<SyntheticCamera> weak = camera;
+            camera = nullptr;
+            cam = nullptr;
+            const auto captured = stream->captured();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            THEN("its destructor has stopped the capture thread") {
+                REQUIRE(weak.expired());
+                REQUIRE(captured == stream->captured());
+            }
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#include "../catch.h"
+
+#include <iostream>
+#include <HAL/CameraCtrl/Implementation/CmosOV3642.h>
+#include <HAL/CameraCtrl/Implementation/CmosOV8825.h>
+#include <HAL/CameraCtrl/Implementation/SyntheticCamera.h>
+#include <HAL/CameraCtrl/Commands/Initialize.h>
+#include <HAL/CameraCtrl/Commands/SetMode.h>
+
+#include <memory>
+
+namespace {
+    constexpr reg_write consecutive[] = {
+        { 0x3800, 0x01 }, { 0x3801, 0x02 }, { 0x3802, 0x03 },
+        { 0x4000, 0x04 },
+        { 0x3803, 0x05 },
+    };
+    
+    constexpr reg_write withReset[] = {
+        { 0x0103, 0x01, true },
+        { 0x3800, 0x01 },
+    };
+}
+
+
+SCENARIO("register tables are programmed in bursts","[registers]") {
+    GIVEN("a register programmer on a simulated bus") {
+        SimulatedSccbBus bus;
+        RegisterProgrammer programmer(bus);
+        
+        WHEN("a table is programmed") {
+            programmer.program(consecutive);
+            THEN("every register holds its value") {
+                REQUIRE(0x01 == bus[0x3800]);
+                REQUIRE(0x03 == bus[0x3802]);
+                REQUIRE(0x04 == bus[0x4000]);
+                REQUIRE(0x05 == bus[0x3803]);
+            }
+            AND_THEN("runs of consecutive addresses take one transaction each") {
+                REQUIRE(3u == bus.transactions());
+            }
+        }
+        
+        WHEN("the same table is programmed again") {
+            programmer.program(consecutive);
+            programmer.program(consecutive);
+            THEN("the registers that already hold their values are skipped") {
+                REQUIRE(3u == bus.transactions());
+            }
+        }
+        
+        WHEN("a table resets the sensor") {
+            programmer.program(consecutive);
+            programmer.program(withReset);
+            programmer.program(consecutive);
+            THEN("the shadow is forgotten and the registers are written again") {
+                REQUIRE(3u + 2u + 3u == bus.transactions());
+            }
+        }
+    }
+}
+
+
+SCENARIO("sensor modes are switched quickly","[registers]") {
+    GIVEN("an initialized OV8825") {
+        auto bus = std::make_shared<SimulatedSccbBus>();
+        std::shared_ptr<ICameraCtrl> cam = std::make_shared<CmosOV8825>(bus);
+        Camera::Initialize init;
+        cam->accept(init);
+        REQUIRE(0x0c == (*bus)[0x3808]);
+        REQUIRE(0xc0 == (*bus)[0x3809]);
+        
+        WHEN("switching between still and video mode") {
+            Camera::SetMode still(Camera::Mode::Still), video(Camera::Mode::Video);
+            cam->accept(still);
+            const auto before = bus->busTimeMs();
+            const auto transactions = bus->transactions();
+            cam->accept(video);
+            THEN("only the changed registers are written, well within 20 ms") {
+                REQUIRE(bus->transactions() - transactions < 10u);
+                REQUIRE(bus->busTimeMs() - before < 20.0);
+                REQUIRE(0x02 == (*bus)[0x3090]);
+                REQUIRE(0x01 == (*bus)[0x0100]);
+            }
+        }
+    }
+}